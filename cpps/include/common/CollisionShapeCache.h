@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <btBulletDynamicsCommon.h>
+
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "./Geometry.h"
+
+enum class CollisionShapeType {
+  BOX,
+  TRIANGLE_MESH,
+  CONVEX_HULL,
+};
+
+struct CollisionShapeKey {
+  // Geometry::getId() and getVersion(), so edited or replaced geometries
+  // miss the cache; 0 for shapes fully described by their parameters
+  uint64_t geometry_id;
+  uint64_t geometry_version;
+  CollisionShapeType type;
+  // Whatever else shapes the result, such as extents, margins or budgets
+  std::array<float, 4> parameters;
+
+  auto operator<=>(const CollisionShapeKey&) const = default;
+};
+
+// Shares one collision shape between every physics module built from the
+// same geometry and parameters. A shape lives as long as some module holds
+// it, so shared shapes must not be rescaled or have their margin changed.
+// Safe to use from several threads. Only shapes that collision queries just
+// read belong here; GImpact shapes keep mutable lock state, so each body
+// gets its own over a shared mesh.
+class CollisionShapeCache {
+ public:
+  static std::shared_ptr<btCollisionShape> getShape(
+      const CollisionShapeKey& key,
+      const std::function<std::unique_ptr<btCollisionShape>()>& create_shape);
+  // Triangles that per-body shapes read, shared the same way
+  static std::shared_ptr<btStridingMeshInterface> getMesh(
+      const CollisionShapeKey& key,
+      const std::function<std::unique_ptr<btStridingMeshInterface>()>&
+          create_mesh);
+  // Shapes and meshes currently alive in the cache
+  static size_t getShapeCount();
+};
@@ -24,8 +24,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <glm/mat3x3.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <utility>
 #include <vector>
 
 #include "./SceneObject.h"
@@ -36,19 +41,146 @@ struct Vertex {
   glm::vec2 texture_coord;
 };
 
+// How vertices are stored on the GPU; each format has its own buffer pool
+enum class VertexFormat {
+  FLOAT,      // Vertex as is
+  QUANTIZED,  // QuantizedVertex, half the size
+};
+
+constexpr size_t VERTEX_FORMAT_COUNT = 2;
+
+// Positions are snorm16 inside a cube around the geometry, decoded in the
+// vertex shader as position * decode.w + decode.xyz. Normals are snorm
+// 10-10-10-2 and texture coordinates half floats, both decoded on fetch.
+struct QuantizedVertex {
+  int16_t position[4];
+  uint32_t normal;
+  uint16_t texture_coord[2];
+};
+
+size_t getVertexSize(VertexFormat format);
+QuantizedVertex quantizeVertex(const Vertex& vertex,
+                               const glm::vec4& position_decode);
+
+// Levels of detail a geometry can hold, the full-resolution one included
+constexpr size_t MAX_LOD_COUNT = 4;
+
+// Rigid body mass distribution in model space
+struct MassProperties {
+  float mass = 0.f;
+  glm::vec3 center_of_mass = glm::vec3(0.f);
+  // About the center of mass
+  glm::mat3 inertia_tensor = glm::mat3(0.f);
+
+  // The same distribution at another total mass
+  MassProperties withMass(float new_mass) const;
+  // Adds a point mass, such as the weight hidden in a loaded die
+  MassProperties withPointMass(float point_mass,
+                               const glm::vec3& position) const;
+};
+
+// Half-open range of elements changed since the last upload
+struct GeometryDirtyRange {
+  size_t begin = 0;
+  size_t end = 0;
+
+  bool isEmpty() const { return begin >= end; }
+  void extend(size_t range_begin, size_t range_end);
+};
+
+// Tells geometries apart for caches. Copies and assignments draw a fresh id,
+// so an id is never shared or reused, unlike an address.
+class GeometryId {
+ public:
+  GeometryId();
+  GeometryId(const GeometryId&) : GeometryId() {}
+  GeometryId& operator=(const GeometryId&);
+
+  uint64_t getValue() const { return value; }
+
+ private:
+  uint64_t value;
+};
+
 class Geometry : public SceneObject {
  public:
   Geometry() {};
-  Geometry(const std::vector<Vertex>& vertices,
-           const std::vector<unsigned int>& indices)
-      : vertices(vertices), indices(indices) {};
+  Geometry(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
+      : vertices(std::move(vertices)), indices(std::move(indices)) {};
 
   const std::vector<Vertex>& getVertices() const { return vertices; };
   const std::vector<unsigned int>& getIndices() const { return indices; };
 
+  // Never 0. Together with the version, names the current contents.
+  uint64_t getId() const { return id.getValue(); }
+  // Bumped whenever vertices or indices are edited
+  uint64_t getVersion() const { return version; }
+
+  // Overwrites elements from first on, growing the arrays when needed; only
+  // the touched span is uploaded unless the geometry outgrows its allocation
+  void updateVertices(size_t first, const std::vector<Vertex>& new_vertices);
+  void updateIndices(size_t first,
+                     const std::vector<unsigned int>& new_indices);
+  void setVertices(const std::vector<Vertex>& new_vertices);
+  void setIndices(const std::vector<unsigned int>& new_indices);
+
+  VertexFormat getVertexFormat() const { return vertex_format; }
+  void setVertexFormat(VertexFormat format);
+  // Identity decode (0, 0, 0, 1) unless the format is quantized
+  const glm::vec4& getPositionDecode() const;
+  // Center in xyz and radius in w of a sphere enclosing every vertex
+  const glm::vec4& getBoundingSphere() const;
+  const glm::vec3& getMinPosition() const;
+  const glm::vec3& getMaxPosition() const;
+  // Skips the scan over the vertices when the bounds are already known
+  void setBounds(const glm::vec3& min_position, const glm::vec3& max_position);
+  // Solid of unit density enclosed by the triangles. Open surfaces fall back
+  // to a solid box of their bounds.
+  const MassProperties& getMassProperties() const;
+
+  // Coarser index lists over the same vertices, finest first; level 0 is
+  // getIndices(). They are not rebuilt when the geometry is edited.
+  void setLodIndices(std::vector<std::vector<unsigned int>> new_lod_indices);
+  size_t getLodCount() const { return lod_indices.size() + 1; }
+  const std::vector<unsigned int>& getLodIndices(size_t lod) const;
+  bool areLodsDirty() const { return are_lods_dirty; }
+
+  const GeometryDirtyRange& getDirtyVertexRange() const {
+    return dirty_vertex_range;
+  }
+  const GeometryDirtyRange& getDirtyIndexRange() const {
+    return dirty_index_range;
+  }
+  void clearDirtyRanges();
+
  protected:
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
+
+ private:
+  GeometryId id;
+  uint64_t version = 0;
+
+  GeometryDirtyRange dirty_vertex_range;
+  GeometryDirtyRange dirty_index_range;
+
+  std::vector<std::vector<unsigned int>> lod_indices;
+  bool are_lods_dirty = false;
+
+  void updateBounds() const;
+  void applyBounds(const glm::vec3& min_position,
+                   const glm::vec3& max_position) const;
+
+  VertexFormat vertex_format = VertexFormat::FLOAT;
+  // Derived from the bounds on demand, as subclasses fill vertices directly
+  mutable glm::vec4 position_decode = glm::vec4(0.f, 0.f, 0.f, 1.f);
+  mutable glm::vec4 bounding_sphere = glm::vec4(0.f);
+  mutable glm::vec3 min_position = glm::vec3(0.f);
+  mutable glm::vec3 max_position = glm::vec3(0.f);
+  mutable bool are_bounds_stale = true;
+
+  mutable MassProperties mass_properties;
+  mutable bool are_mass_properties_stale = true;
 };
 
 class TriangleGeometry : public Geometry {
@@ -72,6 +204,8 @@ class CubeGeometry : public Geometry {
   float getHalfWidth() const { return half_width; };
   float getHalfHeight() const { return half_height; };
   float getHalfDepth() const { return half_depth; };
+  // One outward normal per face, in the order the faces are generated
+  static const std::vector<glm::vec3>& getFaceNormals();
 
  private:
   float half_width;
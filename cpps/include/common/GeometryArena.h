@@ -0,0 +1,62 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+// Usage of one arena, in elements (vertices or indices)
+struct GeometryArenaStatistics {
+  size_t capacity;
+  size_t used;
+  size_t free_block_count;
+  size_t largest_free_block;
+
+  float getOccupancy() const;
+  // 0 when all free space is one block, approaching 1 as it splinters
+  float getFragmentation() const;
+};
+
+// First-fit sub-allocator for a shared vertex or index buffer. It only does
+// the bookkeeping; the owner resizes the GPU buffer when grow() is called.
+class GeometryArena {
+ public:
+  static constexpr size_t INVALID_OFFSET = static_cast<size_t>(-1);
+
+  // Returns INVALID_OFFSET when no free block is large enough
+  size_t allocate(size_t size);
+  void free(size_t offset, size_t size);
+  // Appends free space at the end
+  void grow(size_t new_capacity);
+
+  size_t getCapacity() const { return capacity; }
+  GeometryArenaStatistics getStatistics() const;
+
+ private:
+  // Offset to size, kept coalesced
+  std::map<size_t, size_t> free_blocks;
+  size_t capacity = 0;
+  size_t used = 0;
+};
@@ -24,11 +24,78 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include "./Geometry.h"
 
+// Post-transform cache size the optimizer targets and measures against
+constexpr size_t VERTEX_CACHE_SIZE = 16;
+
+// Furthest the first LOD may stray from the full mesh, as a fraction of its
+// bounding radius
+constexpr float LOD_MAX_ERROR = 0.01f;
+
+struct VertexCacheStatistics {
+  // Transformed vertices per triangle; 0.5 is the ideal for large grids
+  float acmr;
+  // Transformed vertices per referenced vertex; 1 is ideal
+  float atvr;
+};
+
+struct GeometryOptimizationStatistics {
+  VertexCacheStatistics before;
+  VertexCacheStatistics after;
+};
+
 class GeometryUtils {
  public:
-  static Geometry loadObjToGeometry(const std::string& obj_path);
+  // Prefers a mesh cache of the current version and imports the OBJ
+  // otherwise, which needs a build with Assimp
+  static Geometry loadGeometry(const std::string& mesh_cache_path,
+                               const std::string& obj_path);
+  static Geometry loadObjToGeometry(const std::string& obj_path,
+                                    bool optimize = true);
+
+  // Runs the vertex cache, overdraw and vertex fetch passes in that order.
+  // Vertices are renumbered, so any LOD chain is dropped.
+  static GeometryOptimizationStatistics optimizeGeometry(Geometry& geometry);
+
+  // Builds up to max_lod_count - 1 coarser index lists, each simplified from
+  // the previous one by the given ratio. Stops early once a level no longer
+  // gets meaningfully smaller.
+  static void generateLods(Geometry& geometry,
+                           size_t max_lod_count = MAX_LOD_COUNT,
+                           float reduction_ratio = 0.5f);
+  // Quadric error metric edge collapse down to about target_index_count,
+  // on vertices welded by position. Borders never move and seams only
+  // collapse along themselves, each vertex taking the closest attributes at
+  // its new position, so the result uses the same vertex list. No collapse
+  // strays further than max_error times the bounding radius.
+  static std::vector<unsigned int> simplifyIndices(
+      const std::vector<Vertex>& vertices,
+      const std::vector<unsigned int>& indices, size_t target_index_count,
+      float max_error = LOD_MAX_ERROR);
+
+  // Tipsify triangle reordering. Cluster starts, in triangles, mark where it
+  // had to jump, which are the only places overdraw sorting may cut.
+  static std::vector<unsigned int> optimizeVertexCache(
+      const std::vector<unsigned int>& indices, size_t vertex_count,
+      std::vector<size_t>* cluster_starts = nullptr,
+      size_t cache_size = VERTEX_CACHE_SIZE);
+  // Orders clusters so that those facing away from the mesh center, which
+  // tend to occlude the rest, are drawn first
+  static std::vector<unsigned int> optimizeOverdraw(
+      const std::vector<Vertex>& vertices,
+      const std::vector<unsigned int>& indices,
+      const std::vector<size_t>& cluster_starts);
+  // Renumbers vertices in order of first use so fetches stay sequential
+  static void optimizeVertexFetch(std::vector<Vertex>& vertices,
+                                  std::vector<unsigned int>& indices);
+
+  // Simulates a FIFO post-transform cache
+  static VertexCacheStatistics getVertexCacheStatistics(
+      const std::vector<unsigned int>& indices, size_t vertex_count,
+      size_t cache_size = VERTEX_CACHE_SIZE);
 };
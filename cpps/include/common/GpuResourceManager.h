@@ -24,12 +24,15 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <vector>
 
 #include "./Camera.h"
 #include "./Geometry.h"
+#include "./GeometryArena.h"
 #include "./Material.h"
 #include "./Mesh.h"
 #include "./UniformDataObject.h"
@@ -43,45 +46,202 @@ typedef unsigned int ShaderProgramId;
 
 typedef unsigned int UniformBufferId;
 
-struct VertexObject {
+typedef unsigned int InstanceBufferId;
+
+#ifdef TARGET_EMSCRIPTEN
+// WebGL cannot block on fences and copies uploads on its own
+constexpr int FRAMES_IN_FLIGHT = 1;
+#else
+constexpr int FRAMES_IN_FLIGHT = 3;
+#endif
+
+// std140 rounds every uniform block up to a multiple of a vec4
+constexpr size_t UNIFORM_BLOCK_SIZE_ALIGNMENT = 16;
+
+struct UniformBufferRange {
+  UniformBufferId uniform_buffer_id;
+  size_t offset;
+  size_t size;
+};
+
+// Place of a UniformDataObject inside the packed uniform arena
+struct UniformArenaEntry {
+  size_t offset;
+  size_t size;
+};
+
+enum class IndexType {
+  UINT16,
+  UINT32,
+};
+
+// The index arena counts in 16-bit units; 32-bit blocks take two each
+constexpr size_t INDEX_ARENA_UNIT_SIZE = sizeof(uint16_t);
+
+// Initial sizes of the shared geometry buffers, in vertices and index units
+constexpr size_t GEOMETRY_POOL_INITIAL_VERTEX_CAPACITY = 1 << 16;
+constexpr size_t GEOMETRY_POOL_INITIAL_INDEX_CAPACITY = 1 << 19;
+
+size_t getIndexSize(IndexType index_type);
+
+// Buffers every geometry of one vertex format is sub-allocated from
+struct GeometryPoolBuffers {
   unsigned int vao_id;
   unsigned int vbo_id;
   unsigned int ebo_id;
+};
+
+struct GeometryPool {
+  GeometryPoolBuffers buffers;
+  GeometryArena vertex_arena;
+  GeometryArena index_arena;
+};
+
+struct GeometryPoolStatistics {
+  GeometryArenaStatistics vertex_arena;
+  GeometryArenaStatistics index_arena;
+};
+
+// Range of a geometry inside the pool; draws add base_vertex to each index
+// and count first_index in elements of index_type
+struct VertexObject {
+  unsigned int vao_id;
   unsigned int vertex_count;
+  unsigned int first_index;
+  int base_vertex;
+  IndexType index_type;
+  // Arena placement, which may differ from the draw offsets above when base
+  // vertices are baked into the indices; index ones are in arena units
+  VertexFormat vertex_format;
+  size_t vertex_offset;
+  size_t vertex_capacity;
+  size_t index_arena_offset;
+  size_t index_arena_capacity;
+  // Decode the vertices were last quantized with
+  glm::vec4 position_decode;
 };
 
+inline size_t getIndexByteOffset(const VertexObject& vertex_object) {
+  return vertex_object.index_arena_offset * INDEX_ARENA_UNIT_SIZE;
+}
+
 class GpuResourceManager {
  public:
   GpuResourceManager() {};
   virtual ~GpuResourceManager() = 0;
 
-  ShaderProgramId getShaderProgram(MaterialType type);
-  const VertexObject& getVertexObject(const Geometry* geometry);
+  ShaderProgramId getShaderProgram(MaterialType type,
+                                   bool is_instanced = false);
+  // Coarser levels share the vertex block and differ only in their indices;
+  // levels the geometry lacks fall back to its coarsest one
+  const VertexObject& getVertexObject(const Geometry* geometry,
+                                      size_t lod = 0);
 
-  const UniformBufferId getUniformBufferId(
+  const UniformBufferRange getUniformBufferRange(
       const UniformDataObject* uniform_data_object);
 
   void upsertVertexObject(const Geometry* geometry);
   void upsertUniformBuffer(const UniformDataObject* uniform_data_object);
 
-  void cleanup();
+  // Uploads the uniform arena into the buffer of the current frame
+  void flushUniformBuffers();
 
- private:
-  virtual ShaderProgramId createShaderProgram(MaterialType type) = 0;
-  virtual VertexObject createVertexObject(const Geometry* geometry) = 0;
+  // Uploads the per-instance data of the current frame in one call
+  void uploadInstanceData(const void* data_ptr, size_t size);
+  InstanceBufferId getInstanceBufferId() const {
+    return instance_buffer_ids[frame_index];
+  }
 
-  virtual UniformBufferId createUniformBuffer() = 0;
+  void beginFrame();
+  void endFrame();
+  // Slot of the frame being recorded; its previous use has been waited on
+  int getFrameIndex() const { return frame_index; }
 
-  virtual void updateVertexObject(const Geometry* geometry) = 0;
+  GeometryPoolStatistics getGeometryPoolStatistics(
+      VertexFormat vertex_format = VertexFormat::FLOAT) const;
+
+  void cleanup();
+
+ private:
+  virtual ShaderProgramId createShaderProgram(MaterialType type,
+                                              bool is_instanced) = 0;
+
+  virtual UniformBufferId createUniformBuffer(size_t size) = 0;
+
+  // Creates the pool on the first call and grows it on later ones, keeping
+  // the contents and the VAO id
+  virtual void reserveGeometryPool(GeometryPoolBuffers& buffers,
+                                   VertexFormat vertex_format,
+                                   size_t old_vertex_capacity,
+                                   size_t vertex_capacity,
+                                   size_t old_index_capacity,
+                                   size_t index_capacity) = 0;
+  // Vertex offsets and counts are in vertices, index ones in bytes
+  virtual void uploadVertices(const GeometryPoolBuffers& buffers,
+                              VertexFormat vertex_format, size_t vertex_offset,
+                              const void* vertices, size_t vertex_count) = 0;
+  virtual void uploadIndices(const GeometryPoolBuffers& buffers,
+                             size_t byte_offset, const void* indices,
+                             size_t size) = 0;
+  // Without base-vertex draws the vertex offset is added to every index
+  virtual bool isBaseVertexSupported() = 0;
   virtual void updateUniformBuffer(UniformBufferId uniform_buffer_id,
                                    const void* data_ptr, size_t size) = 0;
 
-  virtual void deleteShaderProgram(MaterialType type) = 0;
-  virtual void deleteVertexObject(const Geometry* index) = 0;
+  virtual void deleteShaderProgram(ShaderProgramId shader_program_id) = 0;
+  virtual void deleteGeometryPool(const GeometryPoolBuffers& buffers) = 0;
   virtual void deleteUniformBuffer(UniformBufferId uniform_buffer_id) = 0;
 
+  virtual InstanceBufferId createInstanceBuffer(size_t size) = 0;
+  virtual void updateInstanceBuffer(InstanceBufferId instance_buffer_id,
+                                    const void* data_ptr, size_t size) = 0;
+  virtual void deleteInstanceBuffer(InstanceBufferId instance_buffer_id) = 0;
+
+  virtual size_t getUniformBufferOffsetAlignment() = 0;
+
+  virtual void waitForFrame(int frame_index) = 0;
+  virtual void fenceFrame(int frame_index) = 0;
+
+  void reserveUniformArena(size_t size);
+  VertexObject allocateVertexObject(VertexFormat vertex_format,
+                                    size_t vertex_count, size_t index_count);
+  size_t allocateIndexBlock(GeometryPool& pool, VertexFormat vertex_format,
+                            size_t index_arena_count);
+  void upsertLodVertexObjects(const Geometry* geometry);
+  // Rebases and narrows the indices as the vertex object needs
+  void uploadIndexRange(const VertexObject& vertex_object,
+                        const unsigned int* indices, size_t first_index,
+                        size_t index_count);
+  IndexType getIndexType(size_t vertex_offset, size_t vertex_count);
+  void growGeometryPool(GeometryPool& pool, VertexFormat vertex_format,
+                        size_t vertex_count, size_t index_arena_count);
+
  protected:
   std::unordered_map<MaterialType, ShaderProgramId> shader_program_ids;
+  std::unordered_map<MaterialType, ShaderProgramId>
+      instanced_shader_program_ids;
   UnorderedPointerMap<Geometry, VertexObject> vertex_objects;
-  UnorderedPointerMap<UniformDataObject, UniformBufferId> uniform_buffer_ids;
+  // Levels from 1 up, allocated alongside the base one
+  UnorderedPointerMap<Geometry, std::vector<VertexObject>> lod_vertex_objects;
+  UnorderedPointerMap<UniformDataObject, UniformArenaEntry>
+      uniform_arena_entries;
+
+ private:
+  // CPU copy of every uniform block, uploaded as a whole; one GPU buffer per
+  // frame in flight so an upload never touches a buffer still being read
+  std::vector<unsigned char> uniform_arena;
+  std::array<UniformBufferId, FRAMES_IN_FLIGHT> uniform_arena_buffer_ids = {};
+  size_t uniform_arena_capacity = 0;
+  size_t uniform_offset_alignment = 0;
+  int stale_uniform_arena_frame_count = 0;
+
+  // Indexed by VertexFormat
+  std::array<GeometryPool, VERTEX_FORMAT_COUNT> geometry_pools = {};
+  std::vector<QuantizedVertex> quantized_vertices;
+  std::vector<unsigned int> rebased_indices;
+  std::vector<uint16_t> narrowed_indices;
+
+  std::array<InstanceBufferId, FRAMES_IN_FLIGHT> instance_buffer_ids = {};
+  size_t instance_buffer_capacity = 0;
+  int frame_index = 0;
 };
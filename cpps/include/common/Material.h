@@ -38,6 +38,8 @@ enum class MaterialType : size_t {
   PHONG = 4,
 };
 
+constexpr size_t MATERIAL_TYPE_COUNT = 5;
+
 class Material : public SceneObject, public UniformDataObject {
  public:
   Material(void* uniform_data_ptr = nullptr, size_t uniform_data_size = 0)
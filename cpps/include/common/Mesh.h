@@ -34,6 +34,8 @@
 
 struct MeshUniformData {
   glm::mat4 model_matrix;
+  // Copied from the geometry; see Geometry::getPositionDecode
+  glm::vec4 position_decode;
 };
 
 class Mesh : public SceneObject, public UniformDataObject {
@@ -44,6 +46,10 @@ class Mesh : public SceneObject, public UniformDataObject {
         UniformDataObject(&uniform_data, sizeof(MeshUniformData)) {}
 
   const glm::mat4& getModelMatrix() const { return uniform_data.model_matrix; }
+  const glm::vec4& getPositionDecode() const {
+    return uniform_data.position_decode;
+  }
+  void setPositionDecode(const glm::vec4& position_decode);
 
   void translate(const glm::vec3& translation);
   void scale(const glm::vec3& scaling);
@@ -52,6 +58,8 @@ class Mesh : public SceneObject, public UniformDataObject {
   void setTranslate(const glm::vec3& translation);
   void setScale(const glm::vec3& scaling);
   void setRotate(const glm::quat& rotation);
+  void setTranslateAndRotate(const glm::vec3& translation,
+                             const glm::quat& rotation);
 
   const glm::vec3& getTranslation() const { return translate_vector; }
   const glm::vec3& getScaling() const { return scale_vector; }
@@ -65,7 +73,8 @@ class Mesh : public SceneObject, public UniformDataObject {
   std::reference_wrapper<Material> material;
 
  private:
-  MeshUniformData uniform_data = {glm::mat4(1.0f)};
+  MeshUniformData uniform_data = {glm::mat4(1.0f),
+                                  glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)};
   glm::vec3 scale_vector = glm::vec3(1.0f);
   glm::vec3 translate_vector = glm::vec3(0.0f);
   glm::quat rotate_quaternion = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
@@ -0,0 +1,57 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "./Geometry.h"
+
+// Bumped whenever the layout below or the processing behind it changes, so
+// stale caches are rejected instead of misread
+constexpr uint32_t MESH_CACHE_VERSION = 2;
+
+// Little-endian file layout: this header, the vertices, the base indices and
+// then the indices of each further level of detail
+struct MeshCacheHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint32_t vertex_count;
+  uint32_t lod_count;
+  std::array<uint32_t, MAX_LOD_COUNT> index_counts;
+  glm::vec3 min_position;
+  glm::vec3 max_position;
+};
+
+// Already processed geometry, loaded without Assimp or any per-vertex work
+class MeshCache {
+ public:
+  static void save(const std::string& path, const Geometry& geometry);
+  // Empty when path is missing or holds no cache of the current version;
+  // throws when a current cache is truncated or indexes past its vertices
+  static std::optional<Geometry> load(const std::string& path);
+};
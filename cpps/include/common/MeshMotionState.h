@@ -0,0 +1,71 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <btBulletDynamicsCommon.h>
+
+#include <vector>
+
+#include "./Mesh.h"
+
+// Receives transforms from Bullet for active bodies and queues itself, so only
+// meshes of bodies that actually moved are updated. Transforms kept here are
+// the mesh's; Bullet sees them moved to the center of mass.
+class MeshMotionState : public btMotionState {
+ public:
+  MeshMotionState(
+      const btTransform& transform,
+      const btTransform& center_of_mass_offset = btTransform::getIdentity())
+      : previous_transform(transform),
+        current_transform(transform),
+        center_of_mass_offset(center_of_mass_offset),
+        inverse_center_of_mass_offset(center_of_mass_offset.inverse()) {}
+
+  void getWorldTransform(btTransform& world_transform) const override;
+  void setWorldTransform(const btTransform& world_transform) override;
+
+  // Restarts interpolation from the transform, e.g. after a teleport
+  void resetTransform(const btTransform& transform);
+
+  void bindMesh(Mesh& mesh,
+                std::vector<MeshMotionState*>& moved_motion_states);
+
+  // Writes the blend of the last two pushed transforms into the mesh. Returns
+  // false once the body stopped receiving transforms and the mesh is final.
+  bool syncMesh(float alpha, bool has_stepped);
+
+ private:
+  void enqueue();
+
+  btTransform previous_transform;
+  btTransform current_transform;
+  btTransform center_of_mass_offset;
+  btTransform inverse_center_of_mass_offset;
+
+  Mesh* mesh = nullptr;
+  std::vector<MeshMotionState*>* moved_motion_states = nullptr;
+  bool is_queued = false;
+  bool was_pushed = false;
+};
@@ -27,19 +27,32 @@
 #include <btBulletDynamicsCommon.h>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <memory>
+#include <vector>
 
 #include "./Geometry.h"
+#include "./Mesh.h"
+#include "./MeshMotionState.h"
 
 class PhysicsModule {
  public:
+  // The shape may be shared with other modules, as the cached ones are. A
+  // zero inertia is taken from the shape.
   PhysicsModule(btScalar mass, btVector3 inertia,
-                std::unique_ptr<btCollisionShape> collision_shape,
-                std::unique_ptr<btMotionState> motion_state);
-  PhysicsModule(btScalar mass, btVector3 inertia, const btTransform& transform)
-      : mass(mass),
-        inertia(inertia),
-        bt_motion_state(std::make_unique<btDefaultMotionState>(transform)) {}
+                std::shared_ptr<btCollisionShape> collision_shape,
+                const btTransform& transform);
+  // The body is placed at the center of mass along the principal axes, with
+  // the shape offset to match, before it can join a world
+  PhysicsModule(const MassProperties& mass_properties,
+                std::shared_ptr<btCollisionShape> collision_shape,
+                const btTransform& transform);
+
+  // The geometry's own distribution scaled to mass, unless a non-zero
+  // inertia is given, which is then used as is about the origin
+  static MassProperties getMassProperties(const Geometry& geometry,
+                                          btScalar mass,
+                                          const btVector3& inertia);
 
   glm::vec3 getPosition() const;
   glm::quat getRotation() const;
@@ -47,14 +60,33 @@ class PhysicsModule {
 
   void setPosition(const glm::vec3& position);
   void setRotation(const glm::quat& rotation);
+  void setLinearVelocity(const glm::vec3& velocity);
+  void setAngularVelocity(const glm::vec3& velocity);
+
+  bool isStatic() const;
+  bool isResting() const;
+
+  // Lets Bullet push transforms of this body straight into the mesh
+  void bindMesh(Mesh& mesh,
+                std::vector<MeshMotionState*>& moved_motion_states);
+
+ private:
+  btTransform getMeshTransform() const;
+  void setMeshTransform(const btTransform& transform);
 
  protected:
-  std::unique_ptr<btCollisionShape> bt_collision_shape;
-  std::unique_ptr<btMotionState> bt_motion_state;
+  std::shared_ptr<btCollisionShape> bt_collision_shape;
+  // Holds the shared shape at an offset when the center of mass is not the
+  // mesh origin
+  std::unique_ptr<btCompoundShape> bt_offset_collision_shape;
+  std::unique_ptr<MeshMotionState> bt_motion_state;
   std::unique_ptr<btRigidBody> bt_rigid_body;
 
   btScalar mass;
+  // Principal moments, in the body frame
   btVector3 inertia;
+  // Body frame relative to the mesh
+  btTransform center_of_mass_offset;
 };
 
 class BoxShapePhysicsModule : public PhysicsModule {
@@ -62,6 +94,10 @@ class BoxShapePhysicsModule : public PhysicsModule {
   BoxShapePhysicsModule(float mass, const btVector3& inertia,
                         const CubeGeometry& cube_geometry,
                         const btTransform& transform);
+
+  // Shared by every cube of the same size
+  static std::shared_ptr<btCollisionShape> getShape(
+      const CubeGeometry& cube_geometry);
 };
 
 class TriangleMeshPhysicsModule : public PhysicsModule {
@@ -70,6 +106,33 @@ class TriangleMeshPhysicsModule : public PhysicsModule {
                             const btVector3& inertia,
                             const btTransform& transform);
 
- private:
-  std::unique_ptr<btTriangleIndexVertexArray> mesh_index_vertex_array;
+  // A btGImpactMeshShape of its own, over a copy of the triangles shared per
+  // geometry
+  static std::shared_ptr<btCollisionShape> getShape(const Geometry& geometry);
+};
+
+struct ConvexHullOptions {
+  // Every contact query walks the hull points, so fewer is cheaper; below 4
+  // the hull keeps all of its points
+  int max_vertex_count = 32;
+  // Above 1, concave models are split into up to this many hulls
+  int max_hull_count = 1;
+  // Share of a hull's volume a split has to carve away to be worth it
+  float min_concavity = 0.05f;
+  float margin = 0.01f;
+};
+
+class ConvexHullPhysicsModule : public PhysicsModule {
+ public:
+  ConvexHullPhysicsModule(const Geometry& geometry, float mass,
+                          const btVector3& inertia,
+                          const btTransform& transform,
+                          const ConvexHullOptions& options = {});
+
+  // A single btConvexHullShape, or a compound shape owning one hull per part
+  // when the geometry is decomposed, shared per geometry and options. The
+  // hulls are shrunk by the margin so the rounded shape Bullet collides with
+  // matches the surface.
+  static std::shared_ptr<btCollisionShape> getShape(
+      const Geometry& geometry, const ConvexHullOptions& options);
 };
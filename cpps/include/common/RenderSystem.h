@@ -24,19 +24,60 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "./GpuResourceManager.h"
 #include "./RenderSystem.h"
 #include "./SceneManager.h"
 #include "./UniformBlock.h"
 
+// Buffer ranges indexed by UniformBlockType; only blocks in mask are bound
+struct UniformBufferBindings {
+  UniformBlockMask mask;
+  std::array<UniformBufferRange, UNIFORM_BLOCK_TYPE_COUNT> ranges;
+};
+
+// Per-instance attributes of instanced draws, mirroring ModelBlock
+struct InstanceData {
+  glm::mat4 model_matrix;
+  glm::vec4 position_decode;
+};
+
 struct RenderItem {
+  // Program, vertex format, material, then geometry, so equal state ends up
+  // adjacent and pooled geometries sharing a material can be batched
+  uint64_t sort_key;
   ShaderProgramId shader_program_id;
   VertexObject vertex_object;
+  UniformBufferBindings uniform_buffer_bindings;
+  // Instanced items draw instance_count copies whose InstanceData starts at
+  // instance_offset bytes in the instance buffer; 0 means a single draw
+  unsigned int instance_count;
+  InstanceBufferId instance_buffer_id;
+  size_t instance_offset;
 };
 
+struct RenderStatistics {
+  int draw_count;
+  int instance_count;
+  int shader_program_change_count;
+  int vertex_array_change_count;
+  int uniform_buffer_change_count;
+  // CPU time spent submitting the queue
+  float submission_ms;
+  // Triangles drawn at each level of detail, instances included
+  std::array<int, MAX_LOD_COUNT> lod_triangle_counts;
+};
+
+uint64_t getRenderItemSortKey(ShaderProgramId shader_program_id,
+                              const VertexObject& vertex_object,
+                              size_t material_key);
+
 class RenderSystem {
  public:
   RenderSystem() = default;
@@ -48,11 +89,14 @@ class RenderSystem {
   virtual void updateWindowSize(int width, int height) = 0;
   virtual void runRenderLoop(
       const std::function<void(float, float)>& render_func) = 0;
-  virtual void drawTriangles(
-      ShaderProgramId shader_program_id, const VertexObject& vertex_object,
-      const std::unordered_map<UniformBlockType, unsigned int>
-          uniform_buffer_map) = 0;
+  // Draws the items in order, skipping state that is already bound;
+  // per-frame buffers are picked by frame_index, below FRAMES_IN_FLIGHT
+  virtual RenderStatistics drawRenderItems(
+      const std::vector<RenderItem>& render_items, int frame_index) = 0;
   virtual void setClearColor(const glm::vec4& color) = 0;
+  // Whether instanced items can be batched into indirect multi-draws, in
+  // which case every mesh should be submitted as an instanced item
+  virtual bool isMultiDrawSupported() const { return false; }
 
  private:
 };
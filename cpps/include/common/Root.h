@@ -24,8 +24,11 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "./Camera.h"
 #include "./Geometry.h"
@@ -41,6 +44,16 @@ struct RootOptions {
   std::reference_wrapper<Camera> camera;
   std::reference_wrapper<AmbientLight> ambient_light;
   std::reference_wrapper<DirectionalLight> directional_light;
+  float physics_tick_rate = 60.f;
+  int max_physics_steps_per_frame = 4;
+  // Runs of meshes sharing geometry and material at least this long are
+  // drawn with one instanced call; 0 disables instancing
+  int min_instance_count = 4;
+  // Below this projected height, as a fraction of the viewport, meshes drop
+  // one level of detail per halving; 0 always draws full resolution
+  float lod_screen_size = 0.25f;
+  // See SceneManagerOptions
+  unsigned int physics_thread_count = 1;
 };
 
 class Root {
@@ -50,10 +63,21 @@ class Root {
   void renderScene(const std::function<void(float, float)>& loop_func);
   void setClearColor(const glm::vec4& color);
 
+  // Counts of the last rendered frame
+  const RenderStatistics& getRenderStatistics() const {
+    return render_statistics;
+  }
+  GeometryPoolStatistics getGeometryPoolStatistics(
+      VertexFormat vertex_format = VertexFormat::FLOAT) const {
+    return gpu_resource_manager->getGeometryPoolStatistics(vertex_format);
+  }
+
  private:
   void updateGpuResources();
-  void simulateDynamicsWorld(float delta_ms);
-  void syncEntityMeshesWithPhysics();
+  int simulateDynamicsWorld(float delta_ms);
+  void syncEntityMeshesWithPhysics(float alpha, bool has_stepped);
+  void buildRenderQueue();
+  void appendInstancedRenderItem(size_t begin, size_t end);
 
  public:
   std::unique_ptr<SceneManager> scene_manager;
@@ -61,4 +85,18 @@ class Root {
  private:
   std::unique_ptr<RenderSystem> render_system;
   std::unique_ptr<GpuResourceManager> gpu_resource_manager;
+
+  float physics_time_step_ms;
+  int max_physics_steps_per_frame;
+  float physics_accumulator_ms = 0.f;
+
+  int min_instance_count;
+  float lod_screen_size;
+  std::array<int, MAX_LOD_COUNT> lod_triangle_counts = {};
+
+  // Kept between frames so their storage is reused
+  std::vector<std::pair<RenderItem, const Mesh*>> mesh_render_items;
+  std::vector<InstanceData> instance_data;
+  std::vector<RenderItem> render_queue;
+  RenderStatistics render_statistics = {};
 };
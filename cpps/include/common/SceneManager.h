@@ -33,18 +33,36 @@
 #include "./Geometry.h"
 #include "./Light.h"
 #include "./Mesh.h"
+#include "./MeshMotionState.h"
+#include "./SettleDetector.h"
+
+struct SceneManagerOptions {
+  // Above 1, narrowphase and constraint solving are spread over a
+  // btDiscreteDynamicsWorldMt; 0 uses every hardware thread. Needs Bullet
+  // built thread safe (DICE_PHYSICS_MULTITHREADING), otherwise the world
+  // stays single-threaded.
+  unsigned int physics_thread_count = 1;
+  SettleDetectorOptions settle_detector_options;
+};
 
 class SceneManager {
  public:
   SceneManager(std::reference_wrapper<Camera> camera,
                std::reference_wrapper<AmbientLight> ambient_light,
-               std::reference_wrapper<DirectionalLight> directional_light);
+               std::reference_wrapper<DirectionalLight> directional_light,
+               const SceneManagerOptions& options = {});
 
   void addEntity(std::reference_wrapper<Entity> entity);
 
+  // Advances the world by exactly one step so results do not depend on the
+  // frame rate, then updates settle_detector
+  void stepDynamicsWorld(float time_step_ms);
+
   const std::vector<std::reference_wrapper<Entity>>& getEntities() const {
     return entities;
   }
+  // 1 unless the world is a btDiscreteDynamicsWorldMt
+  unsigned int getPhysicsThreadCount() const { return physics_thread_count; }
 
   std::reference_wrapper<Camera> camera;
   std::reference_wrapper<AmbientLight> ambient_light;
@@ -54,9 +72,19 @@ class SceneManager {
   std::unique_ptr<btBroadphaseInterface> bt_broadphase;
   std::unique_ptr<btDefaultCollisionConfiguration> bt_collision_configuration;
   std::unique_ptr<btCollisionDispatcher> bt_dispatcher;
-  std::unique_ptr<btSequentialImpulseConstraintSolver> bt_solver;
+  // A pool of solvers, one island each, on the multithreaded world
+  std::unique_ptr<btConstraintSolver> bt_solver;
+  // Solves islands too large for a single pooled solver
+  std::unique_ptr<btConstraintSolver> bt_solver_mt;
   std::unique_ptr<btDiscreteDynamicsWorld> bt_dynamics_world;
 
+  // Motion states that received a transform since their mesh was last synced
+  std::vector<MeshMotionState*> moved_motion_states;
+
+  // Watches rolled dice for when they come to rest
+  SettleDetector settle_detector;
+
  private:
   std::vector<std::reference_wrapper<Entity>> entities;
+  unsigned int physics_thread_count = 1;
 };
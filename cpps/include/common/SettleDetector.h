@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "./Entity.h"
+#include "./Geometry.h"
+
+struct SettleDetectorOptions {
+  // A body counts as still below both speeds, in m/s and rad/s
+  float linear_velocity_threshold = 0.02f;
+  float angular_velocity_threshold = 0.1f;
+  // Consecutive still steps before a roll is over; Bullet deactivating the
+  // body ends it at once
+  int rest_step_count = 10;
+  // Faces are read against this direction, opposite to gravity
+  glm::vec3 up = glm::vec3(0.f, 1.f, 0.f);
+};
+
+struct SettleEvent {
+  std::reference_wrapper<Entity> entity;
+  // Index into the face normals registered for the entity's geometry
+  int face;
+  // Steps since the entity was watched or last reset
+  int step_count;
+};
+
+// Decides when rolled dice come to rest and which face landed up, so callers
+// can stop stepping as soon as every watched die has settled.
+class SettleDetector {
+ public:
+  SettleDetector(const SettleDetectorOptions& options = {})
+      : options(options) {}
+
+  // Face normals are in mesh space, one per face of the die
+  void registerFaceNormals(const Geometry& geometry,
+                           std::vector<glm::vec3> face_normals);
+
+  // on_settled is called once per roll, on the step the entity comes to rest.
+  // Its geometry needs registered face normals.
+  void watch(Entity& entity,
+             std::function<void(const SettleEvent&)> on_settled = nullptr);
+  void unwatch(const Entity& entity);
+
+  // Starts a new roll for every watched entity
+  void reset();
+  // Called after each step of the dynamics world
+  void update();
+
+  bool isWatching() const { return !watched_entities.empty(); }
+  // True when no watched entity is still rolling
+  bool isSettled() const { return rolling_count == 0; }
+  // Reads the upward face right now, settled or not
+  int getUpwardFace(const Entity& entity) const;
+
+ private:
+  struct WatchedEntity {
+    std::reference_wrapper<Entity> entity;
+    std::function<void(const SettleEvent&)> on_settled;
+    int step_count = 0;
+    int still_step_count = 0;
+    bool is_settled = false;
+  };
+
+  bool isStill(const Entity& entity) const;
+
+  SettleDetectorOptions options;
+  std::unordered_map<const Geometry*, std::vector<glm::vec3>> face_normals;
+  std::vector<WatchedEntity> watched_entities;
+  size_t rolling_count = 0;
+};
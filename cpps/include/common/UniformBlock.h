@@ -38,6 +38,18 @@ enum class UniformBlockType : size_t {
   DIRECTIONAL_LIGHT = 4,
 };
 
+constexpr size_t UNIFORM_BLOCK_TYPE_COUNT = 5;
+
+// Bit i is set when the block with UniformBlockType i is used
+typedef unsigned int UniformBlockMask;
+
+// Every program binds a block type to the same point, fixed at link time
+inline unsigned int getUniformBlockBindingPoint(UniformBlockType type) {
+  return static_cast<unsigned int>(type);
+}
+
 std::string getUniformBlockName(UniformBlockType type);
 
-std::vector<UniformBlockType> getUniformBlockTypes(MaterialType material_type);
\ No newline at end of file
+std::vector<UniformBlockType> getUniformBlockTypes(MaterialType material_type);
+
+UniformBlockMask getUniformBlockMask(MaterialType material_type);
\ No newline at end of file
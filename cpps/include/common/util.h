@@ -26,6 +26,7 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 struct PointerMapHash {
   template <class T>
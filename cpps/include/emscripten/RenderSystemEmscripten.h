@@ -42,10 +42,8 @@ class RenderSystemEmscripten : public RenderSystem {
   void updateWindowSize(int width, int height) override;
   void runRenderLoop(
       const std::function<void(float, float)>& render_func) override;
-  void drawTriangles(ShaderProgramId shader_program_id,
-                     const VertexObject& vertex_object,
-                     const std::unordered_map<UniformBlockType, unsigned int>
-                         uniform_buffer_map) override;
+  RenderStatistics drawRenderItems(const std::vector<RenderItem>& render_items,
+                                   int frame_index) override;
   void setClearColor(const glm::vec4& color) override;
 
  private:
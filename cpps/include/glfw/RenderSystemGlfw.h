@@ -29,12 +29,23 @@
 // Fix include order; glad must be included before GLFW
 #include <GLFW/glfw3.h>
 
+#include <array>
 #include <functional>
+#include <vector>
 
 #include "./GpuResourceManager.h"
 #include "./RenderSystem.h"
 #include "./SceneManager.h"
 
+// Layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
 class RenderSystemGlfw : public RenderSystem {
  public:
   RenderSystemGlfw(int width, int height);
@@ -43,12 +54,24 @@ class RenderSystemGlfw : public RenderSystem {
   void updateWindowSize(int width, int height) override;
   void runRenderLoop(
       const std::function<void(float, float)>& render_func) override;
-  void drawTriangles(ShaderProgramId shader_program_id,
-                     const VertexObject& vertex_object,
-                     const std::unordered_map<UniformBlockType, unsigned int>
-                         uniform_buffer_map) override;
+  RenderStatistics drawRenderItems(const std::vector<RenderItem>& render_items,
+                                   int frame_index) override;
   void setClearColor(const glm::vec4& color) override;
+  bool isMultiDrawSupported() const override {
+    return is_multi_draw_indirect_supported;
+  }
 
  private:
+  RenderStatistics drawRenderItemsIndirect(
+      const std::vector<RenderItem>& render_items, int frame_index);
+
   GLFWwindow* window;
+
+  bool is_multi_draw_indirect_supported = false;
+  // One buffer per frame in flight, like the instance buffers, so commands
+  // are never rewritten while an earlier frame may still read them
+  std::array<GLuint, FRAMES_IN_FLIGHT> indirect_buffer_ids = {};
+  // In commands; shared by every buffer, which only grow
+  size_t indirect_buffer_capacity = 0;
+  std::vector<DrawElementsIndirectCommand> draw_commands;
 };
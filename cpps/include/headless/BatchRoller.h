@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+struct RollRequest {
+  glm::vec3 position;
+  glm::quat rotation;
+  glm::vec3 linear_velocity;
+  glm::vec3 angular_velocity;
+  unsigned int seed;
+};
+
+struct RollResult {
+  unsigned int seed;
+  int face;  // Index of the upward face in CubeGeometry order
+  int step_count;
+  bool settled;
+};
+
+// Collision shapes the die can use, to compare their contact cost
+enum class DieShape {
+  BOX,
+  CONVEX_HULL,
+  TRIANGLE_MESH,
+};
+
+struct BatchRollerOptions {
+  DieShape die_shape = DieShape::BOX;
+  float die_half_size = 0.1f;
+  float die_mass = 1.f;
+  float floor_height = -2.f;
+  float time_step_ms = 1000.f / 60.f;
+  int max_steps_per_roll = 1200;
+  unsigned int thread_count = 0;  // 0 uses every hardware thread
+};
+
+// Rolls a single die many times on a pool of threads. Each worker owns its
+// own HeadlessRoot, so broadphase, dispatcher, solver and dynamics world are
+// never shared between threads.
+class BatchRoller {
+ public:
+  BatchRoller(const BatchRollerOptions& options) : options(options) {};
+
+  std::vector<RollResult> roll(const std::vector<RollRequest>& requests);
+
+  static RollRequest makeRandomRequest(unsigned int seed);
+  unsigned int getThreadCount() const;
+
+ private:
+  BatchRollerOptions options;
+};
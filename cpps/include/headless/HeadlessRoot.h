@@ -0,0 +1,79 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "./Camera.h"
+#include "./Light.h"
+#include "./SceneManager.h"
+
+struct HeadlessRootOptions {
+  std::reference_wrapper<Camera> camera;
+  std::reference_wrapper<AmbientLight> ambient_light;
+  std::reference_wrapper<DirectionalLight> directional_light;
+  float time_step_ms = 1000.f / 60.f;
+  int max_steps_per_roll = 1200;
+  // See SceneManagerOptions; keep 1 when several roots step in parallel
+  unsigned int physics_thread_count = 1;
+};
+
+struct RollStatistics {
+  int roll_count;
+  long long step_count;
+  float elapsed_ms;
+
+  float getRollsPerSecond() const;
+  float getStepsPerSecond() const;
+};
+
+// Steps the dynamics world of a SceneManager without any window, GPU context
+// or GpuResourceManager, as fast as the CPU allows.
+class HeadlessRoot {
+ public:
+  HeadlessRoot(const HeadlessRootOptions& options);
+
+  // Clears contacts left over from the previous roll, then steps until every
+  // entity watched by the scene's settle detector has settled, or every body
+  // rests when nothing is watched, or the step budget is spent. Returns the
+  // number of steps.
+  int simulateRoll();
+
+  // Calls setup_func(roll_index) before each roll to place the entities.
+  RollStatistics simulateRolls(int roll_count,
+                               const std::function<void(int)>& setup_func);
+
+ private:
+  bool isSceneResting() const;
+  void clearContacts();
+
+ public:
+  std::unique_ptr<SceneManager> scene_manager;
+
+ private:
+  float time_step_ms;
+  int max_steps_per_roll;
+};
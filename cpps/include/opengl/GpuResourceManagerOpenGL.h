@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "./GpuResourceManager.h"
@@ -35,18 +36,40 @@ class GpuResourceManagerOpenGL : public GpuResourceManager {
   ~GpuResourceManagerOpenGL() override;
 
  private:
-  ShaderProgramId createShaderProgram(MaterialType type) override;
+  ShaderProgramId createShaderProgram(MaterialType type,
+                                      bool is_instanced) override;
   ShaderProgramId createShaderProgramWithSources(
       const char* vertex_shader_source, const char* fragment_shader_source);
 
-  VertexObject createVertexObject(const Geometry* geometry) override;
-  void updateVertexObject(const Geometry* geometry) override;
+  void reserveGeometryPool(GeometryPoolBuffers& buffers,
+                           VertexFormat vertex_format,
+                           size_t old_vertex_capacity, size_t vertex_capacity,
+                           size_t old_index_capacity,
+                           size_t index_capacity) override;
+  void uploadVertices(const GeometryPoolBuffers& buffers,
+                      VertexFormat vertex_format, size_t vertex_offset,
+                      const void* vertices, size_t vertex_count) override;
+  void uploadIndices(const GeometryPoolBuffers& buffers, size_t byte_offset,
+                     const void* indices, size_t size) override;
+  bool isBaseVertexSupported() override;
 
-  UniformBufferId createUniformBuffer() override;
+  UniformBufferId createUniformBuffer(size_t size) override;
   void updateUniformBuffer(UniformBufferId uniform_buffer_id,
                            const void* data_ptr, size_t size) override;
 
-  void deleteShaderProgram(MaterialType type) override;
-  void deleteVertexObject(const Geometry* geometry) override;
+  void deleteShaderProgram(ShaderProgramId shader_program_id) override;
+  void deleteGeometryPool(const GeometryPoolBuffers& buffers) override;
   void deleteUniformBuffer(UniformBufferId uniform_buffer_id) override;
+
+  InstanceBufferId createInstanceBuffer(size_t size) override;
+  void updateInstanceBuffer(InstanceBufferId instance_buffer_id,
+                            const void* data_ptr, size_t size) override;
+  void deleteInstanceBuffer(InstanceBufferId instance_buffer_id) override;
+
+  size_t getUniformBufferOffsetAlignment() override;
+
+  void waitForFrame(int frame_index) override;
+  void fenceFrame(int frame_index) override;
+
+  std::array<GLsync, FRAMES_IN_FLIGHT> frame_fences = {};
 };
@@ -0,0 +1,48 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "./RenderSystem.h"
+#include "./opengl.h"
+
+// Per-item draw state shared by the OpenGL and WebGL render systems
+
+GLenum getIndexGlType(IndexType index_type);
+
+bool isSameUniformRange(const UniformBufferRange& lhs,
+                        const UniformBufferRange& rhs);
+
+// Binds only the ranges that differ from bound_ranges and counts the changes
+void bindUniformBufferRanges(
+    const UniformBufferBindings& bindings,
+    std::array<UniformBufferRange, UNIFORM_BLOCK_TYPE_COUNT>& bound_ranges,
+    RenderStatistics& statistics);
+
+// Points the per-instance attributes at instance_offset in the buffer
+void bindInstanceData(InstanceBufferId instance_buffer_id,
+                      size_t instance_offset);
@@ -33,4 +33,9 @@ struct ShaderSource {
   std::string fragment_shader_source;
 };
 
-ShaderSource getShaderSource(MaterialType type);
+// Instanced programs read InstanceData from these attribute locations (the
+// matrix takes four) instead of ModelBlock
+constexpr unsigned int INSTANCE_MODEL_MATRIX_LOCATION = 3;
+constexpr unsigned int INSTANCE_POSITION_DECODE_LOCATION = 7;
+
+ShaderSource getShaderSource(MaterialType type, bool is_instanced = false);
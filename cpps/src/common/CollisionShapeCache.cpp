@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./CollisionShapeCache.h"
+
+#include <map>
+#include <mutex>
+
+namespace {
+
+std::mutex shapes_mutex;
+std::map<CollisionShapeKey, std::weak_ptr<btCollisionShape>> shapes;
+std::map<CollisionShapeKey, std::weak_ptr<btStridingMeshInterface>> meshes;
+
+template <typename T>
+std::shared_ptr<T> getCachedObject(
+    std::map<CollisionShapeKey, std::weak_ptr<T>>& objects,
+    const CollisionShapeKey& key,
+    const std::function<std::unique_ptr<T>()>& create_object) {
+  std::lock_guard<std::mutex> lock(shapes_mutex);
+
+  auto& cached_object = objects[key];
+  if (auto object = cached_object.lock()) {
+    return object;
+  }
+
+  // The last owner drops the entry, unless a new object already replaced it
+  std::shared_ptr<T> object(
+      create_object().release(), [&objects, key](T* released_object) {
+        delete released_object;
+
+        std::lock_guard<std::mutex> lock(shapes_mutex);
+        auto it = objects.find(key);
+        if (it != objects.end() && it->second.expired()) {
+          objects.erase(it);
+        }
+      });
+  cached_object = object;
+
+  return object;
+}
+
+}  // namespace
+
+std::shared_ptr<btCollisionShape> CollisionShapeCache::getShape(
+    const CollisionShapeKey& key,
+    const std::function<std::unique_ptr<btCollisionShape>()>& create_shape) {
+  return getCachedObject(shapes, key, create_shape);
+}
+
+std::shared_ptr<btStridingMeshInterface> CollisionShapeCache::getMesh(
+    const CollisionShapeKey& key,
+    const std::function<std::unique_ptr<btStridingMeshInterface>()>&
+        create_mesh) {
+  return getCachedObject(meshes, key, create_mesh);
+}
+
+size_t CollisionShapeCache::getShapeCount() {
+  std::lock_guard<std::mutex> lock(shapes_mutex);
+  return shapes.size() + meshes.size();
+}
@@ -25,8 +25,8 @@
 #include "./Entity.h"
 
 void Entity::syncMeshWithPhysics() {
-  mesh->setTranslate(physics_module->getPosition());
-  mesh->setRotate(physics_module->getRotation());
+  mesh->setTranslateAndRotate(physics_module->getPosition(),
+                              physics_module->getRotation());
 }
 
 void Entity::syncPhysicsWithMesh() {
@@ -24,7 +24,346 @@
 
 #include "./Geometry.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <stdexcept>
+
+size_t getVertexSize(VertexFormat format) {
+  switch (format) {
+    case VertexFormat::FLOAT:
+      return sizeof(Vertex);
+    case VertexFormat::QUANTIZED:
+      return sizeof(QuantizedVertex);
+    default:
+      throw std::runtime_error("Invalid VertexFormat");
+  }
+}
+
+QuantizedVertex quantizeVertex(const Vertex& vertex,
+                               const glm::vec4& position_decode) {
+  glm::vec3 position =
+      (vertex.position - glm::vec3(position_decode)) / position_decode.w;
+
+  QuantizedVertex quantized_vertex = {};
+  for (int i = 0; i < 3; i++) {
+    quantized_vertex.position[i] =
+        static_cast<int16_t>(glm::packSnorm1x16(position[i]));
+  }
+  quantized_vertex.normal =
+      glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.f));
+  quantized_vertex.texture_coord[0] =
+      glm::packHalf1x16(vertex.texture_coord.x);
+  quantized_vertex.texture_coord[1] =
+      glm::packHalf1x16(vertex.texture_coord.y);
+
+  return quantized_vertex;
+}
+
+void GeometryDirtyRange::extend(size_t range_begin, size_t range_end) {
+  if (isEmpty()) {
+    begin = range_begin;
+    end = range_end;
+    return;
+  }
+
+  begin = std::min(begin, range_begin);
+  end = std::max(end, range_end);
+}
+
+namespace {
+
+std::atomic<uint64_t> next_geometry_id = 1;
+
+}  // namespace
+
+GeometryId::GeometryId() : value(next_geometry_id++) {}
+
+GeometryId& GeometryId::operator=(const GeometryId&) {
+  value = next_geometry_id++;
+  return *this;
+}
+
+void Geometry::updateVertices(size_t first,
+                              const std::vector<Vertex>& new_vertices) {
+  if (first + new_vertices.size() > vertices.size()) {
+    vertices.resize(first + new_vertices.size());
+  }
+
+  std::copy(new_vertices.begin(), new_vertices.end(), vertices.begin() + first);
+  dirty_vertex_range.extend(first, first + new_vertices.size());
+  are_bounds_stale = true;
+  are_mass_properties_stale = true;
+  version++;
+  needs_to_update = true;
+}
+
+void Geometry::updateIndices(size_t first,
+                             const std::vector<unsigned int>& new_indices) {
+  if (first + new_indices.size() > indices.size()) {
+    indices.resize(first + new_indices.size());
+  }
+
+  std::copy(new_indices.begin(), new_indices.end(), indices.begin() + first);
+  dirty_index_range.extend(first, first + new_indices.size());
+  are_mass_properties_stale = true;
+  version++;
+  needs_to_update = true;
+}
+
+void Geometry::setVertices(const std::vector<Vertex>& new_vertices) {
+  vertices = new_vertices;
+  dirty_vertex_range.extend(0, vertices.size());
+  are_bounds_stale = true;
+  are_mass_properties_stale = true;
+  version++;
+  needs_to_update = true;
+}
+
+void Geometry::setIndices(const std::vector<unsigned int>& new_indices) {
+  indices = new_indices;
+  dirty_index_range.extend(0, indices.size());
+  are_mass_properties_stale = true;
+  version++;
+  needs_to_update = true;
+}
+
+void Geometry::setVertexFormat(VertexFormat format) {
+  vertex_format = format;
+  are_bounds_stale = true;
+  needs_to_update = true;
+}
+
+const glm::vec4& Geometry::getPositionDecode() const {
+  updateBounds();
+  return position_decode;
+}
+
+const glm::vec4& Geometry::getBoundingSphere() const {
+  updateBounds();
+  return bounding_sphere;
+}
+
+const glm::vec3& Geometry::getMinPosition() const {
+  updateBounds();
+  return min_position;
+}
+
+const glm::vec3& Geometry::getMaxPosition() const {
+  updateBounds();
+  return max_position;
+}
+
+void Geometry::setBounds(const glm::vec3& min_position,
+                         const glm::vec3& max_position) {
+  applyBounds(min_position, max_position);
+  are_bounds_stale = false;
+}
+
+void Geometry::updateBounds() const {
+  if (!are_bounds_stale) {
+    return;
+  }
+
+  glm::vec3 new_min_position = glm::vec3(0.f);
+  glm::vec3 new_max_position = glm::vec3(0.f);
+  if (!vertices.empty()) {
+    new_min_position = vertices[0].position;
+    new_max_position = vertices[0].position;
+  }
+  for (auto& vertex : vertices) {
+    new_min_position = glm::min(new_min_position, vertex.position);
+    new_max_position = glm::max(new_max_position, vertex.position);
+  }
+
+  applyBounds(new_min_position, new_max_position);
+  are_bounds_stale = false;
+}
+
+void Geometry::applyBounds(const glm::vec3& new_min_position,
+                           const glm::vec3& new_max_position) const {
+  min_position = new_min_position;
+  max_position = new_max_position;
+
+  glm::vec3 center = (min_position + max_position) * 0.5f;
+  glm::vec3 half_extent = (max_position - min_position) * 0.5f;
+  bounding_sphere = glm::vec4(center, glm::length(half_extent));
+
+  position_decode = glm::vec4(0.f, 0.f, 0.f, 1.f);
+  if (vertex_format == VertexFormat::QUANTIZED) {
+    // One scale for all axes lets the decode fit in a single vec4
+    float scale = std::max({half_extent.x, half_extent.y, half_extent.z});
+    position_decode = glm::vec4(center, scale > 0.f ? scale : 1.f);
+  }
+}
+
+// Polyhedral mass properties by the divergence theorem, after Eberly
+static void getTriangleSubexpressions(double w0, double w1, double w2,
+                                      double& f1, double& f2, double& f3,
+                                      double& g0, double& g1, double& g2) {
+  double temp0 = w0 + w1;
+  double temp1 = w0 * w0;
+  double temp2 = temp1 + w1 * temp0;
+  f1 = temp0 + w2;
+  f2 = temp2 + w2 * f1;
+  f3 = w0 * temp1 + w1 * temp2 + w2 * f2;
+  g0 = f2 + w0 * (f1 + w0);
+  g1 = f2 + w1 * (f1 + w1);
+  g2 = f2 + w2 * (f1 + w2);
+}
+
+const MassProperties& Geometry::getMassProperties() const {
+  if (!are_mass_properties_stale) {
+    return mass_properties;
+  }
+
+  // Integrals of 1, x, y, z, x^2, y^2, z^2, xy, yz and zx over the volume
+  std::array<double, 10> integrals = {};
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    glm::dvec3 p0 = vertices[indices[i]].position;
+    glm::dvec3 p1 = vertices[indices[i + 1]].position;
+    glm::dvec3 p2 = vertices[indices[i + 2]].position;
+    glm::dvec3 d = glm::cross(p1 - p0, p2 - p0);
+
+    std::array<glm::dvec3, 6> f;
+    for (int axis = 0; axis < 3; axis++) {
+      getTriangleSubexpressions(p0[axis], p1[axis], p2[axis], f[0][axis],
+                                f[1][axis], f[2][axis], f[3][axis],
+                                f[4][axis], f[5][axis]);
+    }
+
+    integrals[0] += d.x * f[0].x;
+    integrals[1] += d.x * f[1].x;
+    integrals[2] += d.y * f[1].y;
+    integrals[3] += d.z * f[1].z;
+    integrals[4] += d.x * f[2].x;
+    integrals[5] += d.y * f[2].y;
+    integrals[6] += d.z * f[2].z;
+    integrals[7] += d.x * (p0.y * f[3].x + p1.y * f[4].x + p2.y * f[5].x);
+    integrals[8] += d.y * (p0.z * f[3].y + p1.z * f[4].y + p2.z * f[5].y);
+    integrals[9] += d.z * (p0.x * f[3].z + p1.x * f[4].z + p2.x * f[5].z);
+  }
+
+  constexpr std::array<double, 10> INTEGRAL_SCALES = {
+      1.0 / 6,   1.0 / 24,  1.0 / 24,  1.0 / 24,  1.0 / 60,
+      1.0 / 60,  1.0 / 60,  1.0 / 120, 1.0 / 120, 1.0 / 120,
+  };
+  for (size_t i = 0; i < integrals.size(); i++) {
+    integrals[i] *= INTEGRAL_SCALES[i];
+  }
+
+  // Inward-facing triangles flip every sign
+  if (integrals[0] < 0.0) {
+    for (auto& integral : integrals) {
+      integral = -integral;
+    }
+  }
+
+  glm::vec3 extent = getMaxPosition() - getMinPosition();
+  double box_volume = static_cast<double>(extent.x) * extent.y * extent.z;
+
+  mass_properties = {};
+  are_mass_properties_stale = false;
+
+  if (integrals[0] <= box_volume * 1e-6) {
+    float mass = extent.x * extent.y * extent.z;
+    glm::vec3 squared_extent = extent * extent;
+    mass_properties.mass = mass;
+    mass_properties.center_of_mass =
+        (getMinPosition() + getMaxPosition()) * 0.5f;
+    mass_properties.inertia_tensor[0][0] =
+        mass * (squared_extent.y + squared_extent.z) / 12.f;
+    mass_properties.inertia_tensor[1][1] =
+        mass * (squared_extent.z + squared_extent.x) / 12.f;
+    mass_properties.inertia_tensor[2][2] =
+        mass * (squared_extent.x + squared_extent.y) / 12.f;
+    return mass_properties;
+  }
+
+  double mass = integrals[0];
+  glm::dvec3 center = glm::dvec3(integrals[1], integrals[2], integrals[3]) /
+                      mass;
+
+  // Moved from the origin to the center of mass
+  glm::dmat3 inertia_tensor(0.0);
+  inertia_tensor[0][0] = integrals[5] + integrals[6] -
+                         mass * (center.y * center.y + center.z * center.z);
+  inertia_tensor[1][1] = integrals[4] + integrals[6] -
+                         mass * (center.z * center.z + center.x * center.x);
+  inertia_tensor[2][2] = integrals[4] + integrals[5] -
+                         mass * (center.x * center.x + center.y * center.y);
+  inertia_tensor[0][1] = inertia_tensor[1][0] =
+      -(integrals[7] - mass * center.x * center.y);
+  inertia_tensor[1][2] = inertia_tensor[2][1] =
+      -(integrals[8] - mass * center.y * center.z);
+  inertia_tensor[0][2] = inertia_tensor[2][0] =
+      -(integrals[9] - mass * center.z * center.x);
+
+  mass_properties.mass = static_cast<float>(mass);
+  mass_properties.center_of_mass = glm::vec3(center);
+  mass_properties.inertia_tensor = glm::mat3(inertia_tensor);
+
+  return mass_properties;
+}
+
+MassProperties MassProperties::withMass(float new_mass) const {
+  if (mass <= 0.f) {
+    return {new_mass, center_of_mass, inertia_tensor};
+  }
+
+  return {new_mass, center_of_mass, inertia_tensor * (new_mass / mass)};
+}
+
+// Inertia of a point mass about the origin of offset
+static glm::mat3 getPointInertia(float mass, const glm::vec3& offset) {
+  return mass * (glm::dot(offset, offset) * glm::mat3(1.f) -
+                 glm::outerProduct(offset, offset));
+}
+
+MassProperties MassProperties::withPointMass(float point_mass,
+                                             const glm::vec3& position) const {
+  float new_mass = mass + point_mass;
+  if (new_mass <= 0.f) {
+    return *this;
+  }
+
+  glm::vec3 new_center_of_mass =
+      (mass * center_of_mass + point_mass * position) / new_mass;
+
+  // Parallel axis theorem for the body, plus the point itself
+  glm::mat3 new_inertia_tensor =
+      inertia_tensor +
+      getPointInertia(mass, center_of_mass - new_center_of_mass) +
+      getPointInertia(point_mass, position - new_center_of_mass);
+
+  return {new_mass, new_center_of_mass, new_inertia_tensor};
+}
+
+void Geometry::setLodIndices(
+    std::vector<std::vector<unsigned int>> new_lod_indices) {
+  if (new_lod_indices.size() >= MAX_LOD_COUNT) {
+    new_lod_indices.resize(MAX_LOD_COUNT - 1);
+  }
+
+  lod_indices = std::move(new_lod_indices);
+  are_lods_dirty = true;
+  needs_to_update = true;
+}
+
+const std::vector<unsigned int>& Geometry::getLodIndices(size_t lod) const {
+  if (lod == 0 || lod_indices.empty()) {
+    return indices;
+  }
+  return lod_indices[std::min(lod, lod_indices.size()) - 1];
+}
+
+void Geometry::clearDirtyRanges() {
+  dirty_vertex_range = {};
+  dirty_index_range = {};
+  are_lods_dirty = false;
+}
 
 std::vector<Vertex> generatePlaneVertices(const glm::vec3& right,
                                           const glm::vec3& up, float half_width,
@@ -90,6 +429,15 @@ std::vector<unsigned int> generatePlaneIndices(int right_segments,
   return indices;
 }
 
+const std::vector<glm::vec3>& CubeGeometry::getFaceNormals() {
+  static const std::vector<glm::vec3> face_normals = {
+      {0.f, 0.f, 1.f},  {0.f, 0.f, -1.f}, {-1.f, 0.f, 0.f},
+      {1.f, 0.f, 0.f},  {0.f, 1.f, 0.f},  {0.f, -1.f, 0.f},
+  };
+
+  return face_normals;
+}
+
 CubeGeometry::CubeGeometry(float half_width, float half_height,
                            float half_depth, int width_segments,
                            int height_segments, int depth_segments)
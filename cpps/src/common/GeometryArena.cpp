@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./GeometryArena.h"
+
+#include <algorithm>
+#include <iterator>
+
+float GeometryArenaStatistics::getOccupancy() const {
+  if (capacity == 0) {
+    return 0.f;
+  }
+  return static_cast<float>(used) / static_cast<float>(capacity);
+}
+
+float GeometryArenaStatistics::getFragmentation() const {
+  size_t free_size = capacity - used;
+  if (free_size == 0) {
+    return 0.f;
+  }
+  return 1.f - static_cast<float>(largest_free_block) /
+                   static_cast<float>(free_size);
+}
+
+size_t GeometryArena::allocate(size_t size) {
+  // Empty blocks need no space, even in a full or unreserved arena
+  if (size == 0) {
+    return 0;
+  }
+
+  for (auto it = free_blocks.begin(); it != free_blocks.end(); it++) {
+    auto [offset, block_size] = *it;
+    if (block_size < size) {
+      continue;
+    }
+
+    free_blocks.erase(it);
+    if (block_size > size) {
+      free_blocks[offset + size] = block_size - size;
+    }
+
+    used += size;
+    return offset;
+  }
+
+  return INVALID_OFFSET;
+}
+
+void GeometryArena::free(size_t offset, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  used -= size;
+
+  auto next = free_blocks.lower_bound(offset);
+  if (next != free_blocks.end() && offset + size == next->first) {
+    size += next->second;
+    next = free_blocks.erase(next);
+  }
+
+  if (next != free_blocks.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+
+  free_blocks[offset] = size;
+}
+
+void GeometryArena::grow(size_t new_capacity) {
+  if (new_capacity <= capacity) {
+    return;
+  }
+
+  size_t old_capacity = capacity;
+  capacity = new_capacity;
+
+  // free() merges the new tail into a trailing free block
+  used += new_capacity - old_capacity;
+  free(old_capacity, new_capacity - old_capacity);
+}
+
+GeometryArenaStatistics GeometryArena::getStatistics() const {
+  GeometryArenaStatistics statistics = {
+      .capacity = capacity,
+      .used = used,
+      .free_block_count = free_blocks.size(),
+      .largest_free_block = 0,
+  };
+
+  for (auto& [_, block_size] : free_blocks) {
+    statistics.largest_free_block =
+        std::max(statistics.largest_free_block, block_size);
+  }
+
+  return statistics;
+}
@@ -25,21 +25,51 @@
 
 #include "./GeometryUtils.h"
 
+#ifdef DICE_USE_ASSIMP
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
 #include <assimp/Importer.hpp>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <functional>
 #include <glm/glm.hpp>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
 #include <vector>
 
-Geometry GeometryUtils::loadObjToGeometry(const std::string& obj_path) {
+#include "./MeshCache.h"
+
+Geometry GeometryUtils::loadGeometry(const std::string& mesh_cache_path,
+                                     const std::string& obj_path) {
+  if (auto geometry = MeshCache::load(mesh_cache_path)) {
+    return std::move(*geometry);
+  }
+  return loadObjToGeometry(obj_path);
+}
+
+Geometry GeometryUtils::loadObjToGeometry(const std::string& obj_path,
+                                          [[maybe_unused]] bool optimize) {
+#ifndef DICE_USE_ASSIMP
+  throw std::runtime_error("Built without Assimp, so " + obj_path +
+                           " must be converted to a mesh cache");
+#else
   // Create an instance of the Assimp importer class
   Assimp::Importer importer;
 
   // Load the OBJ file with minimal processing needed
   const aiScene* scene =
       importer.ReadFile(obj_path, aiProcess_Triangulate | aiProcess_FlipUVs |
-                                      aiProcess_GenNormals);
+                                      aiProcess_GenNormals |
+                                      aiProcess_JoinIdenticalVertices);
 
   // Check for errors
   if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
@@ -86,5 +116,679 @@ Geometry GeometryUtils::loadObjToGeometry(const std::string& obj_path) {
   }
 
   // Return the Geometry object
-  return Geometry(vertices, indices);
+  Geometry geometry(std::move(vertices), std::move(indices));
+  if (optimize) {
+    optimizeGeometry(geometry);
+    generateLods(geometry);
+  }
+
+  return geometry;
+#endif
+}
+
+GeometryOptimizationStatistics GeometryUtils::optimizeGeometry(
+    Geometry& geometry) {
+  std::vector<Vertex> vertices = geometry.getVertices();
+  std::vector<unsigned int> indices = geometry.getIndices();
+
+  GeometryOptimizationStatistics statistics = {};
+  statistics.before = getVertexCacheStatistics(indices, vertices.size());
+
+  std::vector<size_t> cluster_starts;
+  indices = optimizeVertexCache(indices, vertices.size(), &cluster_starts);
+  indices = optimizeOverdraw(vertices, indices, cluster_starts);
+  optimizeVertexFetch(vertices, indices);
+
+  statistics.after = getVertexCacheStatistics(indices, vertices.size());
+
+  geometry.setVertices(vertices);
+  geometry.setIndices(indices);
+  if (geometry.getLodCount() > 1) {
+    geometry.setLodIndices({});
+  }
+
+  return statistics;
+}
+
+void GeometryUtils::generateLods(Geometry& geometry, size_t max_lod_count,
+                                 float reduction_ratio) {
+  auto& vertices = geometry.getVertices();
+  std::vector<std::vector<unsigned int>> lod_indices;
+  const std::vector<unsigned int>* previous_indices = &geometry.getIndices();
+
+  // Each level is drawn at about half the size of the previous one, so it
+  // may stray twice as far for the same error on screen
+  float max_error = LOD_MAX_ERROR;
+  for (size_t lod = 1; lod < std::min(max_lod_count, MAX_LOD_COUNT); lod++) {
+    size_t previous_count = previous_indices->size();
+    size_t target_count =
+        static_cast<size_t>(previous_count / 3 * reduction_ratio) * 3;
+
+    auto indices = simplifyIndices(vertices, *previous_indices, target_count,
+                                   max_error);
+    max_error *= 2.f;
+    // Locked borders and the error bound can keep a level from shrinking
+    if (indices.empty() || indices.size() * 10 > previous_count * 9) {
+      break;
+    }
+
+    lod_indices.push_back(optimizeVertexCache(indices, vertices.size()));
+    previous_indices = &lod_indices.back();
+  }
+
+  geometry.setLodIndices(std::move(lod_indices));
+}
+
+namespace {
+
+// Symmetric 4x4 plane quadric, stored as its upper triangle
+struct Quadric {
+  double a2 = 0, ab = 0, ac = 0, ad = 0;
+  double b2 = 0, bc = 0, bd = 0;
+  double c2 = 0, cd = 0;
+  double d2 = 0;
+
+  void addPlane(const glm::dvec3& normal, double d, double weight) {
+    a2 += weight * normal.x * normal.x;
+    ab += weight * normal.x * normal.y;
+    ac += weight * normal.x * normal.z;
+    ad += weight * normal.x * d;
+    b2 += weight * normal.y * normal.y;
+    bc += weight * normal.y * normal.z;
+    bd += weight * normal.y * d;
+    c2 += weight * normal.z * normal.z;
+    cd += weight * normal.z * d;
+    d2 += weight * d * d;
+  }
+
+  Quadric& operator+=(const Quadric& other) {
+    a2 += other.a2, ab += other.ab, ac += other.ac, ad += other.ad;
+    b2 += other.b2, bc += other.bc, bd += other.bd;
+    c2 += other.c2, cd += other.cd;
+    d2 += other.d2;
+    return *this;
+  }
+
+  // Sum of squared distances to the accumulated planes
+  double evaluate(const glm::dvec3& p) const {
+    return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z +
+           2 * ad * p.x + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y +
+           c2 * p.z * p.z + 2 * cd * p.z + d2;
+  }
+};
+
+// Between welded positions, so every vertex at from moves along
+struct EdgeCollapse {
+  double cost;
+  unsigned int from;
+  unsigned int to;
+  size_t from_version;
+  size_t to_version;
+
+  bool operator>(const EdgeCollapse& other) const { return cost > other.cost; }
+};
+
+}  // namespace
+
+std::vector<unsigned int> GeometryUtils::simplifyIndices(
+    const std::vector<Vertex>& vertices,
+    const std::vector<unsigned int>& indices, size_t target_index_count,
+    float max_error) {
+  size_t vertex_count = vertices.size();
+  size_t triangle_count = indices.size() / 3;
+
+  // Vertices sharing a position are welded for topology. The vertices of one
+  // position are its wedges; more than one means an attribute seam.
+  std::vector<unsigned int> position_ids(vertex_count);
+  std::vector<glm::dvec3> positions;
+  {
+    std::map<std::tuple<float, float, float>, unsigned int> position_map;
+    for (unsigned int v = 0; v < vertex_count; v++) {
+      auto& p = vertices[v].position;
+      auto [it, is_inserted] = position_map.emplace(
+          std::make_tuple(p.x, p.y, p.z),
+          static_cast<unsigned int>(positions.size()));
+      if (is_inserted) {
+        positions.push_back(glm::dvec3(p));
+      }
+      position_ids[v] = it->second;
+    }
+  }
+  size_t position_count = positions.size();
+
+  // Edges with a single triangle lie on a border, which never moves
+  std::vector<bool> is_locked(position_count, false);
+  {
+    std::map<std::pair<unsigned int, unsigned int>, int> edge_use_counts;
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+      unsigned int a = position_ids[indices[i]];
+      unsigned int b = position_ids[indices[i - i % 3 + (i + 1) % 3]];
+      edge_use_counts[std::minmax(a, b)]++;
+    }
+
+    for (auto& [edge, use_count] : edge_use_counts) {
+      if (use_count == 1) {
+        is_locked[edge.first] = true;
+        is_locked[edge.second] = true;
+      }
+    }
+  }
+
+  std::vector<std::array<unsigned int, 3>> triangles(triangle_count);
+  std::vector<bool> is_triangle_removed(triangle_count, false);
+  std::vector<std::vector<size_t>> position_triangles(position_count);
+  std::vector<Quadric> quadrics(position_count);
+  // Area behind each quadric, to turn its cost into a mean squared distance
+  std::vector<double> quadric_weights(position_count, 0.0);
+
+  glm::dvec3 min_position(std::numeric_limits<double>::max());
+  glm::dvec3 max_position(std::numeric_limits<double>::lowest());
+  for (auto& position : positions) {
+    min_position = glm::min(min_position, position);
+    max_position = glm::max(max_position, position);
+  }
+  double max_distance =
+      position_count > 0
+          ? max_error * glm::length(max_position - min_position) * 0.5
+          : 0.0;
+
+  for (size_t t = 0; t < triangle_count; t++) {
+    triangles[t] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+
+    glm::dvec3 p0 = positions[position_ids[triangles[t][0]]];
+    glm::dvec3 cross =
+        glm::cross(positions[position_ids[triangles[t][1]]] - p0,
+                   positions[position_ids[triangles[t][2]]] - p0);
+    double double_area = glm::length(cross);
+    if (double_area > 0.0) {
+      glm::dvec3 normal = cross / double_area;
+      Quadric quadric;
+      quadric.addPlane(normal, -glm::dot(normal, p0), double_area * 0.5);
+      for (auto v : triangles[t]) {
+        quadrics[position_ids[v]] += quadric;
+        quadric_weights[position_ids[v]] += double_area * 0.5;
+      }
+    }
+
+    for (auto v : triangles[t]) {
+      position_triangles[position_ids[v]].push_back(t);
+    }
+  }
+
+  auto hasPosition = [&](size_t t, unsigned int position_id) {
+    return std::any_of(triangles[t].begin(), triangles[t].end(),
+                       [&](unsigned int v) {
+                         return position_ids[v] == position_id;
+                       });
+  };
+
+  auto getWedges = [&](unsigned int position_id) {
+    std::vector<unsigned int> wedges;
+    for (auto t : position_triangles[position_id]) {
+      if (is_triangle_removed[t]) {
+        continue;
+      }
+      for (auto v : triangles[t]) {
+        if (position_ids[v] == position_id &&
+            std::find(wedges.begin(), wedges.end(), v) == wedges.end()) {
+          wedges.push_back(v);
+        }
+      }
+    }
+    return wedges;
+  };
+
+  // Bumped whenever a position's quadric grows, which makes queued collapses
+  // involving it stale
+  std::vector<size_t> versions(position_count, 0);
+  std::vector<bool> is_collapsed(position_count, false);
+  std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>,
+                      std::greater<EdgeCollapse>>
+      collapses;
+
+  auto pushCollapse = [&](unsigned int from, unsigned int to) {
+    if (is_locked[from] || from == to) {
+      return;
+    }
+    Quadric quadric = quadrics[from];
+    quadric += quadrics[to];
+    collapses.push({quadric.evaluate(positions[to]), from, to,
+                    versions[from], versions[to]});
+  };
+
+  for (auto& triangle : triangles) {
+    for (int i = 0; i < 3; i++) {
+      unsigned int a = position_ids[triangle[i]];
+      unsigned int b = position_ids[triangle[(i + 1) % 3]];
+      pushCollapse(a, b);
+      pushCollapse(b, a);
+    }
+  }
+
+  // Seams may only slide along themselves: either neither end is on one, or
+  // both are and the triangles beside the edge use different wedges
+  auto isSeamCompatible = [&](unsigned int from, unsigned int to,
+                              size_t from_wedge_count, size_t to_wedge_count) {
+    if (from_wedge_count == 1 && to_wedge_count == 1) {
+      return true;
+    }
+    if (from_wedge_count == 1 || to_wedge_count == 1) {
+      return false;
+    }
+
+    std::vector<std::pair<unsigned int, unsigned int>> wedge_pairs;
+    for (auto t : position_triangles[from]) {
+      if (is_triangle_removed[t] || !hasPosition(t, to)) {
+        continue;
+      }
+
+      std::pair<unsigned int, unsigned int> wedge_pair;
+      for (auto v : triangles[t]) {
+        if (position_ids[v] == from) {
+          wedge_pair.first = v;
+        } else if (position_ids[v] == to) {
+          wedge_pair.second = v;
+        }
+      }
+      if (!wedge_pairs.empty() && wedge_pairs.front() != wedge_pair) {
+        return true;
+      }
+      wedge_pairs.push_back(wedge_pair);
+    }
+    return false;
+  };
+
+  // Moving from onto to must not turn any surviving triangle around
+  auto isCollapseValid = [&](unsigned int from, unsigned int to) {
+    for (auto t : position_triangles[from]) {
+      if (is_triangle_removed[t] || hasPosition(t, to)) {
+        continue;
+      }
+
+      std::array<glm::dvec3, 3> corners;
+      for (int i = 0; i < 3; i++) {
+        corners[i] = positions[position_ids[triangles[t][i]]];
+      }
+      glm::dvec3 before =
+          glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+      for (int i = 0; i < 3; i++) {
+        if (position_ids[triangles[t][i]] == from) {
+          corners[i] = positions[to];
+        }
+      }
+      glm::dvec3 after =
+          glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+      if (glm::dot(before, after) <= 0.0) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // The wedge at to whose attributes are closest, preferring the ones the
+  // wedge already shares a triangle with
+  auto getTargetWedge = [&](unsigned int wedge, unsigned int to,
+                            const std::vector<unsigned int>& to_wedges) {
+    std::vector<unsigned int> adjacent_wedges;
+    for (auto t : position_triangles[to]) {
+      if (is_triangle_removed[t] ||
+          std::find(triangles[t].begin(), triangles[t].end(), wedge) ==
+              triangles[t].end()) {
+        continue;
+      }
+      for (auto v : triangles[t]) {
+        if (position_ids[v] == to) {
+          adjacent_wedges.push_back(v);
+        }
+      }
+    }
+    auto& candidates = adjacent_wedges.empty() ? to_wedges : adjacent_wedges;
+
+    auto getDistance = [&](unsigned int v) {
+      return glm::dot(vertices[v].normal - vertices[wedge].normal,
+                      vertices[v].normal - vertices[wedge].normal) +
+             glm::dot(vertices[v].texture_coord - vertices[wedge].texture_coord,
+                      vertices[v].texture_coord -
+                          vertices[wedge].texture_coord);
+    };
+    return *std::min_element(
+        candidates.begin(), candidates.end(),
+        [&](unsigned int a, unsigned int b) {
+          return getDistance(a) < getDistance(b);
+        });
+  };
+
+  size_t live_triangle_count = triangle_count;
+  while (live_triangle_count * 3 > target_index_count && !collapses.empty()) {
+    EdgeCollapse collapse = collapses.top();
+    collapses.pop();
+
+    unsigned int from = collapse.from;
+    unsigned int to = collapse.to;
+    if (is_collapsed[from] || is_collapsed[to]) {
+      continue;
+    }
+    if (collapse.from_version != versions[from] ||
+        collapse.to_version != versions[to]) {
+      // Requeue with the current cost if the edge still exists
+      bool is_adjacent = std::any_of(
+          position_triangles[from].begin(), position_triangles[from].end(),
+          [&](size_t t) {
+            return !is_triangle_removed[t] && hasPosition(t, to);
+          });
+      if (is_adjacent) {
+        pushCollapse(from, to);
+      }
+      continue;
+    }
+
+    // The cost is area weighted, so compare it as a mean squared distance
+    double weight = quadric_weights[from] + quadric_weights[to];
+    if (weight > 0.0 && collapse.cost > weight * max_distance * max_distance) {
+      continue;
+    }
+
+    std::vector<unsigned int> from_wedges = getWedges(from);
+    std::vector<unsigned int> to_wedges = getWedges(to);
+    if (from_wedges.empty() || to_wedges.empty() ||
+        !isSeamCompatible(from, to, from_wedges.size(), to_wedges.size()) ||
+        !isCollapseValid(from, to)) {
+      continue;
+    }
+
+    std::map<unsigned int, unsigned int> wedge_targets;
+    for (auto wedge : from_wedges) {
+      wedge_targets[wedge] = getTargetWedge(wedge, to, to_wedges);
+    }
+
+    for (auto t : position_triangles[from]) {
+      if (is_triangle_removed[t]) {
+        continue;
+      }
+      if (hasPosition(t, to)) {
+        is_triangle_removed[t] = true;
+        live_triangle_count--;
+        continue;
+      }
+
+      for (auto& v : triangles[t]) {
+        if (position_ids[v] == from) {
+          v = wedge_targets[v];
+        }
+      }
+      position_triangles[to].push_back(t);
+    }
+
+    quadrics[to] += quadrics[from];
+    quadric_weights[to] += quadric_weights[from];
+    is_collapsed[from] = true;
+    position_triangles[from].clear();
+    versions[to]++;
+
+    for (auto t : position_triangles[to]) {
+      if (is_triangle_removed[t]) {
+        continue;
+      }
+      for (auto v : triangles[t]) {
+        unsigned int position_id = position_ids[v];
+        if (position_id != to) {
+          pushCollapse(position_id, to);
+          pushCollapse(to, position_id);
+        }
+      }
+    }
+  }
+
+  std::vector<unsigned int> simplified_indices;
+  simplified_indices.reserve(live_triangle_count * 3);
+  for (size_t t = 0; t < triangle_count; t++) {
+    if (!is_triangle_removed[t]) {
+      simplified_indices.insert(simplified_indices.end(),
+                                triangles[t].begin(), triangles[t].end());
+    }
+  }
+
+  return simplified_indices;
+}
+
+std::vector<unsigned int> GeometryUtils::optimizeVertexCache(
+    const std::vector<unsigned int>& indices, size_t vertex_count,
+    std::vector<size_t>* cluster_starts, size_t cache_size) {
+  size_t triangle_count = indices.size() / 3;
+
+  // Triangles around each vertex, in compressed rows
+  std::vector<size_t> adjacency_offsets(vertex_count + 1, 0);
+  for (auto index : indices) {
+    adjacency_offsets[index + 1]++;
+  }
+  std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(),
+                   adjacency_offsets.begin());
+
+  std::vector<size_t> adjacency(indices.size());
+  std::vector<size_t> fill_offsets(adjacency_offsets.begin(),
+                                   adjacency_offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); i++) {
+    adjacency[fill_offsets[indices[i]]++] = i / 3;
+  }
+
+  std::vector<size_t> live_triangle_counts(vertex_count);
+  for (size_t v = 0; v < vertex_count; v++) {
+    live_triangle_counts[v] = adjacency_offsets[v + 1] - adjacency_offsets[v];
+  }
+
+  std::vector<size_t> cache_timestamps(vertex_count, 0);
+  std::vector<bool> is_emitted(triangle_count, false);
+  std::vector<unsigned int> dead_ends;
+  std::vector<unsigned int> candidates;
+
+  std::vector<unsigned int> optimized_indices;
+  optimized_indices.reserve(triangle_count * 3);
+
+  size_t timestamp = cache_size + 1;
+  size_t cursor = 0;
+  bool is_jump = true;
+  long long fanning_vertex = vertex_count > 0 ? 0 : -1;
+
+  while (fanning_vertex >= 0) {
+    if (is_jump && cluster_starts != nullptr &&
+        live_triangle_counts[fanning_vertex] > 0) {
+      cluster_starts->push_back(optimized_indices.size() / 3);
+    }
+
+    candidates.clear();
+    for (size_t a = adjacency_offsets[fanning_vertex];
+         a < adjacency_offsets[fanning_vertex + 1]; a++) {
+      size_t triangle = adjacency[a];
+      if (is_emitted[triangle]) {
+        continue;
+      }
+
+      for (size_t k = 0; k < 3; k++) {
+        unsigned int v = indices[triangle * 3 + k];
+        optimized_indices.push_back(v);
+        dead_ends.push_back(v);
+        candidates.push_back(v);
+        live_triangle_counts[v]--;
+
+        if (timestamp - cache_timestamps[v] > cache_size) {
+          cache_timestamps[v] = timestamp++;
+        }
+      }
+      is_emitted[triangle] = true;
+    }
+
+    // Prefer the candidate that stays in cache longest without its
+    // remaining triangles pushing it out
+    fanning_vertex = -1;
+    size_t best_priority = 0;
+    for (auto v : candidates) {
+      if (live_triangle_counts[v] == 0) {
+        continue;
+      }
+
+      size_t priority = 0;
+      if (timestamp - cache_timestamps[v] + 2 * live_triangle_counts[v] <=
+          cache_size) {
+        priority = timestamp - cache_timestamps[v];
+      }
+
+      if (fanning_vertex < 0 || priority > best_priority) {
+        best_priority = priority;
+        fanning_vertex = v;
+      }
+    }
+
+    is_jump = fanning_vertex < 0;
+    if (!is_jump) {
+      continue;
+    }
+
+    // Dead end: back up through recently used vertices, then scan forward
+    while (!dead_ends.empty()) {
+      unsigned int v = dead_ends.back();
+      dead_ends.pop_back();
+      if (live_triangle_counts[v] > 0) {
+        fanning_vertex = v;
+        break;
+      }
+    }
+
+    while (fanning_vertex < 0 && cursor < vertex_count) {
+      if (live_triangle_counts[cursor] > 0) {
+        fanning_vertex = static_cast<long long>(cursor);
+      }
+      cursor++;
+    }
+  }
+
+  return optimized_indices;
+}
+
+std::vector<unsigned int> GeometryUtils::optimizeOverdraw(
+    const std::vector<Vertex>& vertices,
+    const std::vector<unsigned int>& indices,
+    const std::vector<size_t>& cluster_starts) {
+  size_t triangle_count = indices.size() / 3;
+  if (cluster_starts.size() <= 1) {
+    return indices;
+  }
+
+  auto getTrianglePosition = [&](size_t triangle, size_t k) {
+    return vertices[indices[triangle * 3 + k]].position;
+  };
+
+  glm::vec3 mesh_centroid = glm::vec3(0.f);
+  for (size_t i = 0; i < indices.size(); i++) {
+    mesh_centroid += vertices[indices[i]].position;
+  }
+  mesh_centroid /= static_cast<float>(indices.size());
+
+  struct Cluster {
+    size_t begin;
+    size_t end;
+    float sort_key;
+  };
+
+  std::vector<Cluster> clusters;
+  for (size_t c = 0; c < cluster_starts.size(); c++) {
+    size_t begin = cluster_starts[c];
+    size_t end =
+        c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count;
+
+    // Area-weighted normal and centroid
+    glm::vec3 normal = glm::vec3(0.f);
+    glm::vec3 centroid = glm::vec3(0.f);
+    float area = 0.f;
+    for (size_t t = begin; t < end; t++) {
+      glm::vec3 p0 = getTrianglePosition(t, 0);
+      glm::vec3 p1 = getTrianglePosition(t, 1);
+      glm::vec3 p2 = getTrianglePosition(t, 2);
+      glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+      float triangle_area = glm::length(cross);
+
+      normal += cross;
+      centroid += (p0 + p1 + p2) * (triangle_area / 3.f);
+      area += triangle_area;
+    }
+
+    float sort_key = 0.f;
+    if (area > 0.f) {
+      centroid /= area;
+      sort_key = glm::dot(centroid - mesh_centroid, glm::normalize(normal));
+    }
+
+    clusters.push_back({begin, end, sort_key});
+  }
+
+  std::stable_sort(clusters.begin(), clusters.end(),
+                   [](const Cluster& lhs, const Cluster& rhs) {
+                     return lhs.sort_key > rhs.sort_key;
+                   });
+
+  std::vector<unsigned int> sorted_indices;
+  sorted_indices.reserve(indices.size());
+  for (auto& cluster : clusters) {
+    sorted_indices.insert(sorted_indices.end(),
+                          indices.begin() + cluster.begin * 3,
+                          indices.begin() + cluster.end * 3);
+  }
+
+  return sorted_indices;
+}
+
+void GeometryUtils::optimizeVertexFetch(std::vector<Vertex>& vertices,
+                                        std::vector<unsigned int>& indices) {
+  constexpr unsigned int UNUSED = static_cast<unsigned int>(-1);
+
+  std::vector<unsigned int> remap(vertices.size(), UNUSED);
+  std::vector<Vertex> fetched_vertices;
+  fetched_vertices.reserve(vertices.size());
+
+  for (auto& index : indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = static_cast<unsigned int>(fetched_vertices.size());
+      fetched_vertices.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+
+  // Vertices no triangle references are dropped
+  vertices = std::move(fetched_vertices);
+}
+
+VertexCacheStatistics GeometryUtils::getVertexCacheStatistics(
+    const std::vector<unsigned int>& indices, size_t vertex_count,
+    size_t cache_size) {
+  std::deque<unsigned int> cache;
+  std::vector<bool> is_referenced(vertex_count, false);
+  size_t transformed_count = 0;
+  size_t referenced_count = 0;
+
+  for (auto index : indices) {
+    if (!is_referenced[index]) {
+      is_referenced[index] = true;
+      referenced_count++;
+    }
+
+    if (std::find(cache.begin(), cache.end(), index) != cache.end()) {
+      continue;
+    }
+
+    transformed_count++;
+    cache.push_back(index);
+    if (cache.size() > cache_size) {
+      cache.pop_front();
+    }
+  }
+
+  size_t triangle_count = indices.size() / 3;
+
+  return {
+      .acmr = triangle_count > 0 ? static_cast<float>(transformed_count) /
+                                       static_cast<float>(triangle_count)
+                                 : 0.f,
+      .atvr = referenced_count > 0 ? static_cast<float>(transformed_count) /
+                                         static_cast<float>(referenced_count)
+                                   : 0.f,
+  };
 }
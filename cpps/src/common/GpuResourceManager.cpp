@@ -24,52 +24,425 @@
 
 #include "./GpuResourceManager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
 GpuResourceManager::~GpuResourceManager() {
   // Empty definition
 }
 
+static size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t getIndexSize(IndexType index_type) {
+  switch (index_type) {
+    case IndexType::UINT16:
+      return sizeof(uint16_t);
+    case IndexType::UINT32:
+      return sizeof(uint32_t);
+    default:
+      throw std::runtime_error("Invalid IndexType");
+  }
+}
+
+// Blocks are rounded to whole 32-bit words so 32-bit indices stay aligned
+static size_t getIndexArenaCount(size_t index_count, IndexType index_type) {
+  return alignUp(index_count * getIndexSize(index_type), sizeof(uint32_t)) /
+         INDEX_ARENA_UNIT_SIZE;
+}
+
 void GpuResourceManager::upsertVertexObject(const Geometry* geometry) {
-  if (vertex_objects.find(geometry) == vertex_objects.end()) {
-    vertex_objects[geometry] = createVertexObject(geometry);
+  auto& vertices = geometry->getVertices();
+  auto& indices = geometry->getIndices();
+  VertexFormat vertex_format = geometry->getVertexFormat();
+
+  GeometryDirtyRange vertex_range = geometry->getDirtyVertexRange();
+  GeometryDirtyRange index_range = geometry->getDirtyIndexRange();
+
+  // A geometry keeps its blocks until it outgrows them, changes format or
+  // needs wider indices
+  auto it = vertex_objects.find(geometry);
+  if (it != vertex_objects.end()) {
+    auto& vertex_object = it->second;
+    IndexType index_type =
+        getIndexType(vertex_object.vertex_offset, vertices.size());
+    if (vertex_object.index_type == IndexType::UINT32) {
+      index_type = IndexType::UINT32;
+    }
+
+    if (vertex_object.vertex_format != vertex_format ||
+        vertex_object.index_type != index_type ||
+        vertex_object.vertex_capacity < vertices.size() ||
+        vertex_object.index_arena_capacity <
+            getIndexArenaCount(indices.size(), index_type)) {
+      auto& pool =
+          geometry_pools[static_cast<size_t>(vertex_object.vertex_format)];
+      pool.vertex_arena.free(vertex_object.vertex_offset,
+                             vertex_object.vertex_capacity);
+      pool.index_arena.free(vertex_object.index_arena_offset,
+                            vertex_object.index_arena_capacity);
+      vertex_objects.erase(it);
+      it = vertex_objects.end();
+    }
+  }
+
+  // New blocks start out empty, so everything is uploaded
+  bool is_reallocated = it == vertex_objects.end();
+  if (is_reallocated) {
+    it = vertex_objects
+             .emplace(geometry,
+                      allocateVertexObject(vertex_format, vertices.size(),
+                                           indices.size()))
+             .first;
+    vertex_range = {0, vertices.size()};
+    index_range = {0, indices.size()};
+  }
+
+  auto& vertex_object = it->second;
+  auto& pool = geometry_pools[static_cast<size_t>(vertex_format)];
+  vertex_object.vertex_count = static_cast<unsigned int>(indices.size());
+
+  // Moved bounds change how every vertex is quantized
+  const glm::vec4& position_decode = geometry->getPositionDecode();
+  if (vertex_object.position_decode != position_decode) {
+    vertex_object.position_decode = position_decode;
+    vertex_range = {0, vertices.size()};
+  }
+
+  // Ranges may reach past arrays that have shrunk since
+  vertex_range.end = std::min(vertex_range.end, vertices.size());
+  index_range.end = std::min(index_range.end, indices.size());
+
+  if (!vertex_range.isEmpty()) {
+    const void* vertex_data = vertices.data() + vertex_range.begin;
+    size_t vertex_count = vertex_range.end - vertex_range.begin;
+
+    if (vertex_format == VertexFormat::QUANTIZED) {
+      quantized_vertices.resize(vertex_count);
+      for (size_t i = 0; i < vertex_count; i++) {
+        quantized_vertices[i] = quantizeVertex(
+            vertices[vertex_range.begin + i], position_decode);
+      }
+      vertex_data = quantized_vertices.data();
+    }
+
+    uploadVertices(pool.buffers, vertex_format,
+                   vertex_object.vertex_offset + vertex_range.begin,
+                   vertex_data, vertex_count);
+  }
+
+  if (!index_range.isEmpty()) {
+    uploadIndexRange(vertex_object, indices.data() + index_range.begin,
+                     index_range.begin, index_range.end - index_range.begin);
+  }
+
+  if (is_reallocated || geometry->areLodsDirty() ||
+      lod_vertex_objects[geometry].size() + 1 != geometry->getLodCount()) {
+    upsertLodVertexObjects(geometry);
   }
-  updateVertexObject(geometry);
+}
+
+void GpuResourceManager::upsertLodVertexObjects(const Geometry* geometry) {
+  auto& base_vertex_object = vertex_objects[geometry];
+  auto& pool =
+      geometry_pools[static_cast<size_t>(base_vertex_object.vertex_format)];
+  auto& lod_objects = lod_vertex_objects[geometry];
+
+  // Levels are small and rarely change, so they are rebuilt whole
+  for (auto& lod_object : lod_objects) {
+    geometry_pools[static_cast<size_t>(lod_object.vertex_format)]
+        .index_arena.free(lod_object.index_arena_offset,
+                          lod_object.index_arena_capacity);
+  }
+  lod_objects.clear();
+
+  for (size_t lod = 1; lod < geometry->getLodCount(); lod++) {
+    auto& indices = geometry->getLodIndices(lod);
+    size_t index_arena_count =
+        getIndexArenaCount(indices.size(), base_vertex_object.index_type);
+
+    VertexObject lod_object = base_vertex_object;
+    lod_object.vertex_count = static_cast<unsigned int>(indices.size());
+    lod_object.index_arena_offset = allocateIndexBlock(
+        pool, base_vertex_object.vertex_format, index_arena_count);
+    lod_object.index_arena_capacity = index_arena_count;
+    lod_object.first_index = static_cast<unsigned int>(
+        getIndexByteOffset(lod_object) /
+        getIndexSize(base_vertex_object.index_type));
+
+    uploadIndexRange(lod_object, indices.data(), 0, indices.size());
+    lod_objects.push_back(lod_object);
+  }
+}
+
+void GpuResourceManager::uploadIndexRange(const VertexObject& vertex_object,
+                                          const unsigned int* indices,
+                                          size_t first_index,
+                                          size_t index_count) {
+  auto& pool =
+      geometry_pools[static_cast<size_t>(vertex_object.vertex_format)];
+
+  if (!isBaseVertexSupported()) {
+    rebased_indices.resize(index_count);
+    for (size_t i = 0; i < index_count; i++) {
+      rebased_indices[i] =
+          indices[i] + static_cast<unsigned int>(vertex_object.vertex_offset);
+    }
+    indices = rebased_indices.data();
+  }
+
+  size_t index_size = getIndexSize(vertex_object.index_type);
+  size_t byte_offset =
+      getIndexByteOffset(vertex_object) + first_index * index_size;
+
+  if (vertex_object.index_type == IndexType::UINT32) {
+    uploadIndices(pool.buffers, byte_offset, indices,
+                  index_count * index_size);
+    return;
+  }
+
+  narrowed_indices.resize(index_count);
+  for (size_t i = 0; i < index_count; i++) {
+    narrowed_indices[i] = static_cast<uint16_t>(indices[i]);
+  }
+  uploadIndices(pool.buffers, byte_offset, narrowed_indices.data(),
+                index_count * index_size);
+}
+
+IndexType GpuResourceManager::getIndexType(size_t vertex_offset,
+                                           size_t vertex_count) {
+  // Baked base vertices count toward the largest index
+  size_t index_limit = vertex_count;
+  if (!isBaseVertexSupported()) {
+    index_limit += vertex_offset;
+  }
+
+  // 0xFFFF is the fixed primitive restart index on WebGL2
+  return index_limit <= 0xFFFF ? IndexType::UINT16 : IndexType::UINT32;
+}
+
+void GpuResourceManager::growGeometryPool(GeometryPool& pool,
+                                          VertexFormat vertex_format,
+                                          size_t vertex_count,
+                                          size_t index_arena_count) {
+  size_t old_vertex_capacity = pool.vertex_arena.getCapacity();
+  size_t old_index_capacity = pool.index_arena.getCapacity();
+
+  // Growing by at least the request guarantees the merged tail fits it
+  size_t vertex_capacity = old_vertex_capacity;
+  if (vertex_count > 0 || old_vertex_capacity == 0) {
+    vertex_capacity =
+        std::max({GEOMETRY_POOL_INITIAL_VERTEX_CAPACITY,
+                  old_vertex_capacity * 2, old_vertex_capacity + vertex_count});
+  }
+
+  size_t index_capacity = old_index_capacity;
+  if (index_arena_count > 0 || old_index_capacity == 0) {
+    index_capacity =
+        std::max({GEOMETRY_POOL_INITIAL_INDEX_CAPACITY, old_index_capacity * 2,
+                  old_index_capacity + index_arena_count});
+  }
+
+  reserveGeometryPool(pool.buffers, vertex_format, old_vertex_capacity,
+                      vertex_capacity, old_index_capacity, index_capacity);
+  pool.vertex_arena.grow(vertex_capacity);
+  pool.index_arena.grow(index_capacity);
+}
+
+VertexObject GpuResourceManager::allocateVertexObject(
+    VertexFormat vertex_format, size_t vertex_count, size_t index_count) {
+  auto& pool = geometry_pools[static_cast<size_t>(vertex_format)];
+  if (pool.buffers.vao_id == 0) {
+    growGeometryPool(pool, vertex_format, 0, 0);
+  }
+
+  size_t vertex_offset = pool.vertex_arena.allocate(vertex_count);
+  if (vertex_offset == GeometryArena::INVALID_OFFSET) {
+    growGeometryPool(pool, vertex_format, vertex_count, 0);
+    vertex_offset = pool.vertex_arena.allocate(vertex_count);
+  }
+
+  // The index width depends on where the vertices landed
+  IndexType index_type = getIndexType(vertex_offset, vertex_count);
+  size_t index_arena_count = getIndexArenaCount(index_count, index_type);
+  size_t index_arena_offset =
+      allocateIndexBlock(pool, vertex_format, index_arena_count);
+
+  bool is_base_vertex_supported = isBaseVertexSupported();
+  size_t first_index =
+      index_arena_offset * INDEX_ARENA_UNIT_SIZE / getIndexSize(index_type);
+
+  return {
+      .vao_id = pool.buffers.vao_id,
+      .vertex_count = static_cast<unsigned int>(index_count),
+      .first_index = static_cast<unsigned int>(first_index),
+      .base_vertex =
+          is_base_vertex_supported ? static_cast<int>(vertex_offset) : 0,
+      .index_type = index_type,
+      .vertex_format = vertex_format,
+      .vertex_offset = vertex_offset,
+      .vertex_capacity = vertex_count,
+      .index_arena_offset = index_arena_offset,
+      .index_arena_capacity = index_arena_count,
+      .position_decode = glm::vec4(0.f, 0.f, 0.f, 1.f),
+  };
+}
+
+size_t GpuResourceManager::allocateIndexBlock(GeometryPool& pool,
+                                              VertexFormat vertex_format,
+                                              size_t index_arena_count) {
+  size_t index_arena_offset = pool.index_arena.allocate(index_arena_count);
+  if (index_arena_offset == GeometryArena::INVALID_OFFSET) {
+    growGeometryPool(pool, vertex_format, 0, index_arena_count);
+    index_arena_offset = pool.index_arena.allocate(index_arena_count);
+  }
+  return index_arena_offset;
 }
 
 void GpuResourceManager::upsertUniformBuffer(const UniformDataObject* object) {
-  if (uniform_buffer_ids.find(object) == uniform_buffer_ids.end()) {
-    uniform_buffer_ids[object] = createUniformBuffer();
+  if (uniform_arena_entries.find(object) == uniform_arena_entries.end()) {
+    if (uniform_offset_alignment == 0) {
+      uniform_offset_alignment = getUniformBufferOffsetAlignment();
+    }
+
+    UniformArenaEntry entry = {
+        .offset = alignUp(uniform_arena.size(), uniform_offset_alignment),
+        .size = alignUp(object->getUniformDataSize(),
+                        UNIFORM_BLOCK_SIZE_ALIGNMENT),
+    };
+    uniform_arena.resize(entry.offset + entry.size);
+    uniform_arena_entries[object] = entry;
+  }
+
+  if (object->getUniformDataSize() > 0) {
+    std::memcpy(uniform_arena.data() + uniform_arena_entries[object].offset,
+                object->getUniformDataPtr(), object->getUniformDataSize());
   }
-  updateUniformBuffer(uniform_buffer_ids[object], object->getUniformDataPtr(),
-                      object->getUniformDataSize());
+
+  // Every buffer of the ring has to receive the new arena once
+  stale_uniform_arena_frame_count = FRAMES_IN_FLIGHT;
 }
 
-ShaderProgramId GpuResourceManager::getShaderProgram(MaterialType type) {
-  if (shader_program_ids.find(type) == shader_program_ids.end()) {
-    shader_program_ids[type] = createShaderProgram(type);
+void GpuResourceManager::flushUniformBuffers() {
+  if (stale_uniform_arena_frame_count == 0) {
+    return;
+  }
+
+  if (uniform_arena.size() > uniform_arena_capacity) {
+    reserveUniformArena(
+        std::max(uniform_arena.size(), uniform_arena_capacity * 2));
   }
-  return shader_program_ids[type];
+
+  updateUniformBuffer(uniform_arena_buffer_ids[frame_index],
+                      uniform_arena.data(), uniform_arena.size());
+  stale_uniform_arena_frame_count--;
+}
+
+void GpuResourceManager::uploadInstanceData(const void* data_ptr,
+                                            size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  if (size > instance_buffer_capacity) {
+    size_t capacity = std::max(size, instance_buffer_capacity * 2);
+    for (auto& instance_buffer_id : instance_buffer_ids) {
+      if (instance_buffer_capacity > 0) {
+        deleteInstanceBuffer(instance_buffer_id);
+      }
+      instance_buffer_id = createInstanceBuffer(capacity);
+    }
+
+    instance_buffer_capacity = capacity;
+  }
+
+  updateInstanceBuffer(instance_buffer_ids[frame_index], data_ptr, size);
+}
+
+void GpuResourceManager::reserveUniformArena(size_t size) {
+  for (auto& uniform_buffer_id : uniform_arena_buffer_ids) {
+    if (uniform_arena_capacity > 0) {
+      deleteUniformBuffer(uniform_buffer_id);
+    }
+    uniform_buffer_id = createUniformBuffer(size);
+  }
+
+  uniform_arena_capacity = size;
+}
+
+void GpuResourceManager::beginFrame() {
+  frame_index = (frame_index + 1) % FRAMES_IN_FLIGHT;
+  waitForFrame(frame_index);
+}
+
+void GpuResourceManager::endFrame() { fenceFrame(frame_index); }
+
+GeometryPoolStatistics GpuResourceManager::getGeometryPoolStatistics(
+    VertexFormat vertex_format) const {
+  auto& pool = geometry_pools[static_cast<size_t>(vertex_format)];
+
+  return {
+      .vertex_arena = pool.vertex_arena.getStatistics(),
+      .index_arena = pool.index_arena.getStatistics(),
+  };
+}
+
+ShaderProgramId GpuResourceManager::getShaderProgram(MaterialType type,
+                                                     bool is_instanced) {
+  auto& program_ids =
+      is_instanced ? instanced_shader_program_ids : shader_program_ids;
+
+  if (program_ids.find(type) == program_ids.end()) {
+    program_ids[type] = createShaderProgram(type, is_instanced);
+  }
+  return program_ids[type];
 }
 
 const VertexObject& GpuResourceManager::getVertexObject(
-    const Geometry* geometry) {
-  return vertex_objects[geometry];
+    const Geometry* geometry, size_t lod) {
+  auto lod_it = lod_vertex_objects.find(geometry);
+  if (lod == 0 || lod_it == lod_vertex_objects.end() ||
+      lod_it->second.empty()) {
+    return vertex_objects[geometry];
+  }
+
+  auto& lod_objects = lod_it->second;
+  return lod_objects[std::min(lod, lod_objects.size()) - 1];
 }
 
-const UniformBufferId GpuResourceManager::getUniformBufferId(
+const UniformBufferRange GpuResourceManager::getUniformBufferRange(
     const UniformDataObject* uniform_data_object) {
-  return uniform_buffer_ids[uniform_data_object];
+  auto& entry = uniform_arena_entries[uniform_data_object];
+
+  return {uniform_arena_buffer_ids[frame_index], entry.offset, entry.size};
 }
 
 void GpuResourceManager::cleanup() {
-  for (auto& [type, _] : shader_program_ids) {
-    deleteShaderProgram(type);
+  for (auto& [_, shader_program_id] : shader_program_ids) {
+    deleteShaderProgram(shader_program_id);
+  }
+
+  for (auto& [_, shader_program_id] : instanced_shader_program_ids) {
+    deleteShaderProgram(shader_program_id);
+  }
+
+  for (auto& pool : geometry_pools) {
+    if (pool.vertex_arena.getCapacity() > 0) {
+      deleteGeometryPool(pool.buffers);
+    }
   }
 
-  for (auto& [index, _] : vertex_objects) {
-    deleteVertexObject(index);
+  if (uniform_arena_capacity > 0) {
+    for (auto& uniform_buffer_id : uniform_arena_buffer_ids) {
+      deleteUniformBuffer(uniform_buffer_id);
+    }
   }
 
-  for (auto& [_, uniform_buffer_id] : uniform_buffer_ids) {
-    deleteUniformBuffer(uniform_buffer_id);
+  if (instance_buffer_capacity > 0) {
+    for (auto& instance_buffer_id : instance_buffer_ids) {
+      deleteInstanceBuffer(instance_buffer_id);
+    }
   }
 }
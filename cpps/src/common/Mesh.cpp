@@ -63,6 +63,19 @@ void Mesh::setRotate(const glm::quat& rotation) {
   updateModelMatrix();
 }
 
+void Mesh::setTranslateAndRotate(const glm::vec3& translation,
+                                 const glm::quat& rotation) {
+  translate_vector = translation;
+  rotate_quaternion = rotation;
+
+  updateModelMatrix();
+}
+
+void Mesh::setPositionDecode(const glm::vec4& position_decode) {
+  uniform_data.position_decode = position_decode;
+  needs_to_update = true;
+}
+
 void Mesh::updateModelMatrix() {
   uniform_data.model_matrix = glm::mat4(1.0f);
   uniform_data.model_matrix =
@@ -0,0 +1,203 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./MeshCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if !defined(TARGET_EMSCRIPTEN) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(Vertex) == 8 * sizeof(float),
+              "Vertex is stored in mesh caches as eight packed floats");
+static_assert(sizeof(unsigned int) == sizeof(uint32_t));
+static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+
+constexpr std::array<char, 4> MESH_CACHE_MAGIC = {'D', 'M', 'S', 'H'};
+
+namespace {
+
+// Read-only view of a whole file, empty when it cannot be read. Desktop maps
+// it so the page cache backs the copy into Geometry; the Emscripten FS
+// already holds preloaded files in memory, so a plain read costs no extra
+// I/O there.
+class MeshCacheFile {
+ public:
+  explicit MeshCacheFile(const std::string& path) {
+#if !defined(TARGET_EMSCRIPTEN) && !defined(_WIN32)
+    int file_descriptor = open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+      return;
+    }
+
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) == 0 && file_stat.st_size > 0) {
+      size = static_cast<size_t>(file_stat.st_size);
+      void* mapping =
+          mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+      if (mapping != MAP_FAILED) {
+        data = static_cast<const unsigned char*>(mapping);
+      }
+    }
+    close(file_descriptor);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+      return;
+    }
+
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    data = buffer.data();
+    size = buffer.size();
+#endif
+  }
+
+  ~MeshCacheFile() {
+#if !defined(TARGET_EMSCRIPTEN) && !defined(_WIN32)
+    if (data != nullptr) {
+      munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+  }
+
+  MeshCacheFile(const MeshCacheFile&) = delete;
+  MeshCacheFile& operator=(const MeshCacheFile&) = delete;
+
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+
+ private:
+  std::vector<unsigned char> buffer;
+};
+
+bool isHeaderValid(const MeshCacheHeader& header) {
+  return header.magic == MESH_CACHE_MAGIC &&
+         header.version == MESH_CACHE_VERSION && header.lod_count > 0 &&
+         header.lod_count <= MAX_LOD_COUNT;
+}
+
+size_t getPayloadSize(const MeshCacheHeader& header) {
+  size_t size = header.vertex_count * sizeof(Vertex);
+  for (uint32_t lod = 0; lod < header.lod_count; lod++) {
+    size += header.index_counts[lod] * sizeof(uint32_t);
+  }
+  return size;
+}
+
+}  // namespace
+
+void MeshCache::save(const std::string& path, const Geometry& geometry) {
+  auto& vertices = geometry.getVertices();
+
+  MeshCacheHeader header = {
+      .magic = MESH_CACHE_MAGIC,
+      .version = MESH_CACHE_VERSION,
+      .vertex_count = static_cast<uint32_t>(vertices.size()),
+      .lod_count = static_cast<uint32_t>(geometry.getLodCount()),
+      .index_counts = {},
+      .min_position = geometry.getMinPosition(),
+      .max_position = geometry.getMaxPosition(),
+  };
+  for (size_t lod = 0; lod < geometry.getLodCount(); lod++) {
+    header.index_counts[lod] =
+        static_cast<uint32_t>(geometry.getLodIndices(lod).size());
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Failed to create mesh cache: " + path);
+  }
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(vertices.data()),
+             vertices.size() * sizeof(Vertex));
+  for (size_t lod = 0; lod < geometry.getLodCount(); lod++) {
+    auto& indices = geometry.getLodIndices(lod);
+    file.write(reinterpret_cast<const char*>(indices.data()),
+               indices.size() * sizeof(uint32_t));
+  }
+
+  if (!file) {
+    throw std::runtime_error("Failed to write mesh cache: " + path);
+  }
+}
+
+std::optional<Geometry> MeshCache::load(const std::string& path) {
+  MeshCacheFile file(path);
+
+  MeshCacheHeader header;
+  if (file.data == nullptr || file.size < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(&header, file.data, sizeof(header));
+
+  if (!isHeaderValid(header)) {
+    return std::nullopt;
+  }
+  if (file.size < sizeof(header) + getPayloadSize(header)) {
+    throw std::runtime_error("Mesh cache is truncated: " + path);
+  }
+
+  const unsigned char* cursor = file.data + sizeof(header);
+
+  std::vector<Vertex> vertices(header.vertex_count);
+  std::memcpy(vertices.data(), cursor, vertices.size() * sizeof(Vertex));
+  cursor += vertices.size() * sizeof(Vertex);
+
+  std::vector<std::vector<unsigned int>> lod_indices(header.lod_count);
+  for (uint32_t lod = 0; lod < header.lod_count; lod++) {
+    auto& indices = lod_indices[lod];
+    indices.resize(header.index_counts[lod]);
+    std::memcpy(indices.data(), cursor, indices.size() * sizeof(uint32_t));
+    cursor += indices.size() * sizeof(uint32_t);
+
+    // The indices go straight into the pooled index buffer
+    if (std::any_of(indices.begin(), indices.end(), [&](unsigned int index) {
+          return index >= header.vertex_count;
+        })) {
+      throw std::runtime_error("Mesh cache index is out of range: " + path);
+    }
+  }
+
+  std::optional<Geometry> geometry(
+      std::in_place, std::move(vertices), std::move(lod_indices[0]));
+  geometry->setBounds(header.min_position, header.max_position);
+  if (header.lod_count > 1) {
+    lod_indices.erase(lod_indices.begin());
+    geometry->setLodIndices(std::move(lod_indices));
+  }
+
+  return geometry;
+}
@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./MeshMotionState.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+void MeshMotionState::getWorldTransform(btTransform& world_transform) const {
+  world_transform = current_transform * center_of_mass_offset;
+}
+
+void MeshMotionState::setWorldTransform(const btTransform& world_transform) {
+  previous_transform = current_transform;
+  current_transform = world_transform * inverse_center_of_mass_offset;
+  was_pushed = true;
+
+  enqueue();
+}
+
+void MeshMotionState::resetTransform(const btTransform& transform) {
+  previous_transform = transform;
+  current_transform = transform;
+
+  enqueue();
+}
+
+void MeshMotionState::bindMesh(
+    Mesh& mesh, std::vector<MeshMotionState*>& moved_motion_states) {
+  this->mesh = &mesh;
+  this->moved_motion_states = &moved_motion_states;
+
+  // Static bodies never receive a transform, so place their mesh once
+  enqueue();
+}
+
+bool MeshMotionState::syncMesh(float alpha, bool has_stepped) {
+  // Bullet stops pushing transforms once the body falls asleep
+  bool is_resting = has_stepped && !was_pushed;
+  if (is_resting) {
+    previous_transform = current_transform;
+    alpha = 1.f;
+  }
+
+  const btVector3& previous_origin = previous_transform.getOrigin();
+  const btVector3& current_origin = current_transform.getOrigin();
+  btQuaternion previous_rotation = previous_transform.getRotation();
+  btQuaternion current_rotation = current_transform.getRotation();
+
+  glm::vec3 translation = glm::mix(
+      glm::vec3(previous_origin.getX(), previous_origin.getY(),
+                previous_origin.getZ()),
+      glm::vec3(current_origin.getX(), current_origin.getY(),
+                current_origin.getZ()),
+      alpha);
+  glm::quat rotation = glm::slerp(
+      glm::quat(previous_rotation.getW(), previous_rotation.getX(),
+                previous_rotation.getY(), previous_rotation.getZ()),
+      glm::quat(current_rotation.getW(), current_rotation.getX(),
+                current_rotation.getY(), current_rotation.getZ()),
+      alpha);
+
+  mesh->setTranslateAndRotate(translation, rotation);
+
+  was_pushed = false;
+  is_queued = !is_resting;
+
+  return is_queued;
+}
+
+void MeshMotionState::enqueue() {
+  if (is_queued || moved_motion_states == nullptr) {
+    return;
+  }
+
+  moved_motion_states->push_back(this);
+  is_queued = true;
+}
@@ -26,115 +26,533 @@
 
 #include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <BulletCollision/Gimpact/btGImpactShape.h>
+#include <LinearMath/btConvexHullComputer.h>
 
+#include <algorithm>
+#include <cmath>
 #include <glm/gtc/quaternion.hpp>
 #include <vector>
 
+#include "./CollisionShapeCache.h"
+
+namespace {
+
+btVector3 toBtVector3(const glm::vec3& vector) {
+  return btVector3(vector.x, vector.y, vector.z);
+}
+
+MassProperties getBoxMassProperties(btScalar mass, const btVector3& inertia) {
+  MassProperties mass_properties;
+  mass_properties.mass = mass;
+  mass_properties.inertia_tensor =
+      glm::mat3(glm::vec3(inertia.x(), 0.f, 0.f),
+                glm::vec3(0.f, inertia.y(), 0.f),
+                glm::vec3(0.f, 0.f, inertia.z()));
+
+  return mass_properties;
+}
+
+}  // namespace
+
 PhysicsModule::PhysicsModule(btScalar mass, btVector3 inertia,
-                             std::unique_ptr<btCollisionShape> collision_shape,
-                             std::unique_ptr<btMotionState> motion_state)
-    : mass(mass),
-      inertia(inertia),
-      bt_collision_shape(std::move(collision_shape)),
-      bt_motion_state(std::move(motion_state)) {
-  btRigidBody::btRigidBodyConstructionInfo rigid_body_ci(
-      mass, bt_motion_state.get(), bt_collision_shape.get(), inertia);
+                             std::shared_ptr<btCollisionShape> collision_shape,
+                             const btTransform& transform)
+    : PhysicsModule(getBoxMassProperties(mass, inertia),
+                    std::move(collision_shape), transform) {}
+
+PhysicsModule::PhysicsModule(const MassProperties& mass_properties,
+                             std::shared_ptr<btCollisionShape> collision_shape,
+                             const btTransform& transform)
+    : bt_collision_shape(std::move(collision_shape)),
+      mass(mass_properties.mass),
+      inertia(0, 0, 0),
+      center_of_mass_offset(btTransform::getIdentity()) {
+  btCollisionShape* body_shape = bt_collision_shape.get();
 
-  bt_rigid_body = std::make_unique<btRigidBody>(rigid_body_ci);
   if (mass > 0) {
-    this->bt_collision_shape.get()->calculateLocalInertia(mass, inertia);
+    const glm::mat3& tensor = mass_properties.inertia_tensor;
+    btMatrix3x3 principal_tensor(tensor[0][0], tensor[1][0], tensor[2][0],
+                                 tensor[0][1], tensor[1][1], tensor[2][1],
+                                 tensor[0][2], tensor[1][2], tensor[2][2]);
+    btMatrix3x3 principal_rotation = btMatrix3x3::getIdentity();
+
+    // Principal axes turn the tensor into the diagonal Bullet expects
+    btScalar off_diagonal = btFabs(tensor[0][1]) + btFabs(tensor[0][2]) +
+                            btFabs(tensor[1][2]);
+    btScalar trace = tensor[0][0] + tensor[1][1] + tensor[2][2];
+    bool is_rotated = off_diagonal > trace * btScalar(1e-5);
+    if (is_rotated) {
+      principal_tensor.diagonalize(principal_rotation, btScalar(1e-5), 20);
+    }
+    inertia = btVector3(principal_tensor[0][0], principal_tensor[1][1],
+                        principal_tensor[2][2]);
+    if (inertia.isZero()) {
+      bt_collision_shape->calculateLocalInertia(mass, inertia);
+    }
+
+    center_of_mass_offset =
+        btTransform(principal_rotation,
+                    toBtVector3(mass_properties.center_of_mass));
+    if (is_rotated ||
+        center_of_mass_offset.getOrigin().length2() > btScalar(1e-12)) {
+      bt_offset_collision_shape = std::make_unique<btCompoundShape>(false, 1);
+      bt_offset_collision_shape->addChildShape(center_of_mass_offset.inverse(),
+                                               bt_collision_shape.get());
+      body_shape = bt_offset_collision_shape.get();
+    } else {
+      center_of_mass_offset.setIdentity();
+    }
+  }
+
+  bt_motion_state =
+      std::make_unique<MeshMotionState>(transform, center_of_mass_offset);
+
+  btRigidBody::btRigidBodyConstructionInfo rigid_body_ci(
+      mass, bt_motion_state.get(), body_shape, inertia);
+  bt_rigid_body = std::make_unique<btRigidBody>(rigid_body_ci);
+}
+
+MassProperties PhysicsModule::getMassProperties(const Geometry& geometry,
+                                                btScalar mass,
+                                                const btVector3& inertia) {
+  if (mass <= 0) {
+    return MassProperties();
+  }
+  if (inertia.isZero()) {
+    return geometry.getMassProperties().withMass(mass);
   }
+
+  return getBoxMassProperties(mass, inertia);
+}
+
+btTransform PhysicsModule::getMeshTransform() const {
+  return bt_rigid_body.get()->getWorldTransform() *
+         center_of_mass_offset.inverse();
+}
+
+void PhysicsModule::setMeshTransform(const btTransform& transform) {
+  bt_rigid_body.get()->setWorldTransform(transform * center_of_mass_offset);
+  bt_motion_state.get()->resetTransform(transform);
 }
 
 glm::vec3 PhysicsModule::getPosition() const {
-  btTransform transform = bt_rigid_body.get()->getWorldTransform();
-  btVector3 origin = transform.getOrigin();
+  btVector3 origin = getMeshTransform().getOrigin();
 
   return glm::vec3(origin.getX(), origin.getY(), origin.getZ());
 }
 
 glm::quat PhysicsModule::getRotation() const {
-  btTransform transform = bt_rigid_body.get()->getWorldTransform();
-  btQuaternion rotation = transform.getRotation();
+  btQuaternion rotation = getMeshTransform().getRotation();
 
   return glm::quat(rotation.getW(), rotation.getX(), rotation.getY(),
                    rotation.getZ());
 }
 
 void PhysicsModule::setPosition(const glm::vec3& position) {
-  btTransform transform = bt_rigid_body.get()->getWorldTransform();
-  btVector3 origin = transform.getOrigin();
-
-  origin.setX(position.x);
-  origin.setY(position.y);
-  origin.setZ(position.z);
+  btTransform transform = getMeshTransform();
 
-  transform.setOrigin(origin);
-  bt_rigid_body.get()->setWorldTransform(transform);
+  transform.setOrigin(toBtVector3(position));
+  setMeshTransform(transform);
 }
 
 void PhysicsModule::setRotation(const glm::quat& rotation) {
-  btTransform transform = bt_rigid_body.get()->getWorldTransform();
+  btTransform transform = getMeshTransform();
   btQuaternion quaternion(rotation.x, rotation.y, rotation.z, rotation.w);
 
   transform.setRotation(quaternion);
-  bt_rigid_body.get()->setWorldTransform(transform);
+  setMeshTransform(transform);
+}
+
+void PhysicsModule::setLinearVelocity(const glm::vec3& velocity) {
+  bt_rigid_body.get()->setLinearVelocity(
+      btVector3(velocity.x, velocity.y, velocity.z));
+  bt_rigid_body.get()->activate(true);
+}
+
+void PhysicsModule::setAngularVelocity(const glm::vec3& velocity) {
+  bt_rigid_body.get()->setAngularVelocity(
+      btVector3(velocity.x, velocity.y, velocity.z));
+  bt_rigid_body.get()->activate(true);
+}
+
+bool PhysicsModule::isStatic() const {
+  return bt_rigid_body.get()->isStaticOrKinematicObject();
+}
+
+bool PhysicsModule::isResting() const {
+  return isStatic() || !bt_rigid_body.get()->isActive();
+}
+
+void PhysicsModule::bindMesh(
+    Mesh& mesh, std::vector<MeshMotionState*>& moved_motion_states) {
+  bt_motion_state.get()->bindMesh(mesh, moved_motion_states);
 }
 
 BoxShapePhysicsModule::BoxShapePhysicsModule(float mass,
                                              const btVector3& inertia,
                                              const CubeGeometry& cube_geometry,
                                              const btTransform& transform)
-    : PhysicsModule(
-          mass, inertia,
-          std::make_unique<btBoxShape>(btVector3(cube_geometry.getHalfWidth(),
-                                                 cube_geometry.getHalfHeight(),
-                                                 cube_geometry.getHalfDepth())),
-          std::make_unique<btDefaultMotionState>(transform)) {}
+    : PhysicsModule(getMassProperties(cube_geometry, mass, inertia),
+                    getShape(cube_geometry), transform) {}
+
+std::shared_ptr<btCollisionShape> BoxShapePhysicsModule::getShape(
+    const CubeGeometry& cube_geometry) {
+  btVector3 half_extents(cube_geometry.getHalfWidth(),
+                         cube_geometry.getHalfHeight(),
+                         cube_geometry.getHalfDepth());
+
+  return CollisionShapeCache::getShape(
+      {
+          .geometry_id = 0,
+          .geometry_version = 0,
+          .type = CollisionShapeType::BOX,
+          .parameters = {half_extents.x(), half_extents.y(),
+                         half_extents.z(), 0.f},
+      },
+      [&]() { return std::make_unique<btBoxShape>(half_extents); });
+}
+
+namespace {
+
+// Bullet reads the triangles in place, so the mesh carries its own copy
+class TriangleMeshData : public btTriangleIndexVertexArray {
+ public:
+  explicit TriangleMeshData(const Geometry& geometry) {
+    auto& geometry_vertices = geometry.getVertices();
+
+    // Packed as three scalars per vertex to match the stride below
+    mesh_vertices.resize(geometry_vertices.size() * 3);
+    for (size_t i = 0; i < geometry_vertices.size(); i++) {
+      mesh_vertices[i * 3] = geometry_vertices[i].position.x;
+      mesh_vertices[i * 3 + 1] = geometry_vertices[i].position.y;
+      mesh_vertices[i * 3 + 2] = geometry_vertices[i].position.z;
+    }
+
+    auto& geometry_indices = geometry.getIndices();
+    mesh_indices.assign(geometry_indices.begin(), geometry_indices.end());
+
+    // Create a btIndexedMesh and set its data
+    btIndexedMesh indexed_mesh;
+    indexed_mesh.m_numTriangles = mesh_indices.size() / 3;
+    indexed_mesh.m_triangleIndexBase =
+        reinterpret_cast<const unsigned char*>(mesh_indices.data());
+    indexed_mesh.m_triangleIndexStride = 3 * sizeof(int);
+    indexed_mesh.m_numVertices = geometry_vertices.size();
+    indexed_mesh.m_vertexBase =
+        reinterpret_cast<const unsigned char*>(mesh_vertices.data());
+    indexed_mesh.m_vertexStride = 3 * sizeof(btScalar);
+
+    addIndexedMesh(indexed_mesh, PHY_INTEGER);
+  }
+
+ private:
+  std::vector<btScalar> mesh_vertices;
+  std::vector<int> mesh_indices;
+};
+
+// Stays locked for its lifetime instead of around every query, so pairs of
+// one body may be queried in parallel by btCollisionDispatcherMt
+class LockedMeshPart : public btGImpactMeshShapePart {
+ public:
+  LockedMeshPart(btStridingMeshInterface* mesh, int part)
+      : btGImpactMeshShapePart(mesh, part) {
+    btGImpactMeshShapePart::lockChildShapes();
+  }
+  ~LockedMeshPart() override { btGImpactMeshShapePart::unlockChildShapes(); }
+
+  void lockChildShapes() const override {}
+  void unlockChildShapes() const override {}
+};
+
+// The mesh base is constructed first, so it outlives the GImpact parts
+struct SharedTriangleMesh {
+  std::shared_ptr<btStridingMeshInterface> mesh;
+};
+
+class TriangleMeshShape : private SharedTriangleMesh,
+                          public btGImpactMeshShape {
+ public:
+  explicit TriangleMeshShape(std::shared_ptr<btStridingMeshInterface> mesh)
+      : SharedTriangleMesh{std::move(mesh)},
+        btGImpactMeshShape(SharedTriangleMesh::mesh.get()) {
+    for (int i = 0; i < m_mesh_parts.size(); i++) {
+      delete m_mesh_parts[i];
+      m_mesh_parts[i] = new LockedMeshPart(SharedTriangleMesh::mesh.get(), i);
+    }
+  }
+};
+
+}  // namespace
 
 TriangleMeshPhysicsModule::TriangleMeshPhysicsModule(
     const Geometry& geometry, float mass, const btVector3& inertia,
     const btTransform& transform)
-    : PhysicsModule(mass, inertia, transform) {
-  auto& geometry_vertices = geometry.getVertices();
+    : PhysicsModule(getMassProperties(geometry, mass, inertia),
+                    getShape(geometry), transform) {}
+
+std::shared_ptr<btCollisionShape> TriangleMeshPhysicsModule::getShape(
+    const Geometry& geometry) {
+  constexpr float TRIANGLE_MESH_MARGIN = 0.04f;
 
-  std::vector<btVector3> vertices =
-      std::vector<btVector3>(geometry_vertices.size());
-  for (int i = 0; i < geometry_vertices.size(); i++) {
-    vertices[i] = btVector3(geometry_vertices[i].position.x,
-                            geometry_vertices[i].position.y,
-                            geometry_vertices[i].position.z);
+  std::shared_ptr<btStridingMeshInterface> mesh = CollisionShapeCache::getMesh(
+      {
+          .geometry_id = geometry.getId(),
+          .geometry_version = geometry.getVersion(),
+          .type = CollisionShapeType::TRIANGLE_MESH,
+          .parameters = {0.f, 0.f, 0.f, 0.f},
+      },
+      [&]() { return std::make_unique<TriangleMeshData>(geometry); });
+
+  auto triangle_mesh_shape =
+      std::make_shared<TriangleMeshShape>(std::move(mesh));
+  triangle_mesh_shape->setMargin(btScalar(TRIANGLE_MESH_MARGIN));
+  triangle_mesh_shape->updateBound();
+
+  return triangle_mesh_shape;
+}
+
+namespace {
+
+// Compound shapes only point at their children, so this one keeps them
+class ConvexDecompositionShape : public btCompoundShape {
+ public:
+  std::vector<std::unique_ptr<btConvexHullShape>> hulls;
+};
+
+struct ConvexHullPart {
+  std::vector<size_t> triangles;
+  btScalar volume = 0;
+  // Halves of the best split and the share of the volume it removes
+  std::vector<size_t> split_triangles[2];
+  btScalar concavity = 0;
+};
+
+std::vector<btVector3> getTrianglePoints(const Geometry& geometry,
+                                         const std::vector<size_t>& triangles) {
+  auto& vertices = geometry.getVertices();
+  auto& indices = geometry.getIndices();
+
+  std::vector<btVector3> points;
+  points.reserve(triangles.size() * 3);
+  for (auto triangle : triangles) {
+    for (size_t i = 0; i < 3; i++) {
+      auto& position = vertices[indices[triangle * 3 + i]].position;
+      points.emplace_back(position.x, position.y, position.z);
+    }
   }
 
-  const auto& indices = geometry.getIndices();
+  return points;
+}
 
-  // Create a btIndexedMesh and set its data
-  btIndexedMesh indexed_mesh;
-  indexed_mesh.m_numTriangles = indices.size() / 3;
-  indexed_mesh.m_triangleIndexBase =
-      reinterpret_cast<const unsigned char*>(indices.data());
-  indexed_mesh.m_triangleIndexStride = 3 * sizeof(int);
-  indexed_mesh.m_numVertices = vertices.size();
-  indexed_mesh.m_vertexBase =
-      reinterpret_cast<const unsigned char*>(vertices.data());
-  indexed_mesh.m_vertexStride = 3 * sizeof(btScalar);
+void computeHull(const std::vector<btVector3>& points, btScalar shrink,
+                 btConvexHullComputer& hull) {
+  hull.compute(reinterpret_cast<const btScalar*>(points.data()),
+               sizeof(btVector3), static_cast<int>(points.size()), shrink,
+               btScalar(0.25));
+}
 
-  mesh_index_vertex_array = std::make_unique<btTriangleIndexVertexArray>();
-  mesh_index_vertex_array->addIndexedMesh(indexed_mesh, PHY_INTEGER);
+btScalar getHullVolume(const std::vector<btVector3>& points) {
+  btConvexHullComputer hull;
+  computeHull(points, 0, hull);
 
-  auto triangle_mesh_shape =
-      std::make_unique<btGImpactMeshShape>(mesh_index_vertex_array.get());
-  triangle_mesh_shape->updateBound();
-  triangle_mesh_shape->setMargin(btScalar(0.04));
+  // Sum of the tetrahedra each face fan forms with the origin
+  btScalar volume = 0;
+  for (int i = 0; i < hull.faces.size(); i++) {
+    const btConvexHullComputer::Edge* first_edge = &hull.edges[hull.faces[i]];
+    const btVector3& origin = hull.vertices[first_edge->getSourceVertex()];
 
-  bt_collision_shape = std::move(triangle_mesh_shape);
+    const btConvexHullComputer::Edge* edge = first_edge->getNextEdgeOfFace();
+    while (edge->getTargetVertex() != first_edge->getSourceVertex()) {
+      volume += origin.dot(hull.vertices[edge->getSourceVertex()].cross(
+          hull.vertices[edge->getTargetVertex()]));
+      edge = edge->getNextEdgeOfFace();
+    }
+  }
 
-  btRigidBody::btRigidBodyConstructionInfo rigid_body_ci(
-      mass, bt_motion_state.get(), bt_collision_shape.get(), inertia);
+  return std::abs(volume) / 6;
+}
 
-  bt_rigid_body = std::make_unique<btRigidBody>(rigid_body_ci);
-  if (mass > 0) {
-    this->bt_collision_shape.get()->calculateLocalInertia(this->mass,
-                                                          this->inertia);
+ConvexHullPart makeConvexHullPart(const Geometry& geometry,
+                                  std::vector<size_t> triangles) {
+  ConvexHullPart part;
+  part.triangles = std::move(triangles);
+  part.volume = getHullVolume(getTrianglePoints(geometry, part.triangles));
+  if (part.triangles.size() < 2 || part.volume <= 0) {
+    return part;
+  }
+
+  auto& vertices = geometry.getVertices();
+  auto& indices = geometry.getIndices();
+  auto getCentroid = [&](size_t triangle) {
+    return (vertices[indices[triangle * 3]].position +
+            vertices[indices[triangle * 3 + 1]].position +
+            vertices[indices[triangle * 3 + 2]].position) /
+           3.f;
+  };
+
+  // Halve the triangles at the median along the longest axis
+  glm::vec3 min_centroid = getCentroid(part.triangles[0]);
+  glm::vec3 max_centroid = min_centroid;
+  for (auto triangle : part.triangles) {
+    min_centroid = glm::min(min_centroid, getCentroid(triangle));
+    max_centroid = glm::max(max_centroid, getCentroid(triangle));
+  }
+
+  glm::vec3 extent = max_centroid - min_centroid;
+  int axis = extent.x >= extent.y && extent.x >= extent.z ? 0
+             : extent.y >= extent.z                       ? 1
+                                                          : 2;
+
+  std::vector<size_t> sorted_triangles = part.triangles;
+  auto median = sorted_triangles.begin() + sorted_triangles.size() / 2;
+  std::nth_element(sorted_triangles.begin(), median, sorted_triangles.end(),
+                   [&](size_t lhs, size_t rhs) {
+                     return getCentroid(lhs)[axis] < getCentroid(rhs)[axis];
+                   });
+
+  part.split_triangles[0].assign(sorted_triangles.begin(), median);
+  part.split_triangles[1].assign(median, sorted_triangles.end());
+
+  btScalar split_volume = 0;
+  for (auto& split_triangles : part.split_triangles) {
+    split_volume +=
+        getHullVolume(getTrianglePoints(geometry, split_triangles));
+  }
+  part.concavity = (part.volume - split_volume) / part.volume;
+
+  return part;
+}
+
+// Greedily splits whichever part loses the most volume by it, as long as
+// that loss says the part is concave
+std::vector<ConvexHullPart> decomposeGeometry(
+    const Geometry& geometry, const ConvexHullOptions& options) {
+  std::vector<size_t> triangles(geometry.getIndices().size() / 3);
+  for (size_t i = 0; i < triangles.size(); i++) {
+    triangles[i] = i;
+  }
+
+  std::vector<ConvexHullPart> parts;
+  parts.push_back(makeConvexHullPart(geometry, std::move(triangles)));
+
+  while (parts.size() < static_cast<size_t>(options.max_hull_count)) {
+    auto most_concave = std::max_element(
+        parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) {
+          return lhs.concavity < rhs.concavity;
+        });
+    if (most_concave->concavity < options.min_concavity) {
+      break;
+    }
+
+    ConvexHullPart part = std::move(*most_concave);
+    *most_concave =
+        makeConvexHullPart(geometry, std::move(part.split_triangles[0]));
+    parts.push_back(
+        makeConvexHullPart(geometry, std::move(part.split_triangles[1])));
+  }
+
+  return parts;
+}
+
+// Keeps the hull points that are extreme along evenly spread directions
+std::unique_ptr<btConvexHullShape> createConvexHullShape(
+    const std::vector<btVector3>& points, const ConvexHullOptions& options) {
+  btConvexHullComputer hull;
+  computeHull(points, options.margin, hull);
+
+  std::vector<btVector3> hull_points;
+  for (int i = 0; i < hull.vertices.size(); i++) {
+    hull_points.push_back(hull.vertices[i]);
   }
+  if (hull_points.empty()) {
+    hull_points = points;
+  }
+
+  // Fewer than a tetrahedron's points cannot bound a volume, so such a
+  // budget is ignored rather than collapsing the hull
+  constexpr int MIN_HULL_VERTEX_COUNT = 4;
+  if (options.max_vertex_count >= MIN_HULL_VERTEX_COUNT &&
+      hull_points.size() > static_cast<size_t>(options.max_vertex_count)) {
+    size_t max_vertex_count = static_cast<size_t>(options.max_vertex_count);
+
+    constexpr float GOLDEN_ANGLE = 2.39996323f;
+
+    std::vector<bool> is_selected(hull_points.size(), false);
+    std::vector<btVector3> selected_points;
+    for (size_t i = 0; i < max_vertex_count; i++) {
+      float y = 1.f - 2.f * (static_cast<float>(i) + 0.5f) /
+                          static_cast<float>(max_vertex_count);
+      float radius = std::sqrt(1.f - y * y);
+      float angle = GOLDEN_ANGLE * static_cast<float>(i);
+      btVector3 direction(std::cos(angle) * radius, y,
+                          std::sin(angle) * radius);
+
+      size_t support = 0;
+      for (size_t j = 1; j < hull_points.size(); j++) {
+        if (hull_points[j].dot(direction) >
+            hull_points[support].dot(direction)) {
+          support = j;
+        }
+      }
+
+      if (!is_selected[support]) {
+        is_selected[support] = true;
+        selected_points.push_back(hull_points[support]);
+      }
+    }
+
+    hull_points = std::move(selected_points);
+  }
+
+  auto shape = std::make_unique<btConvexHullShape>(
+      reinterpret_cast<const btScalar*>(hull_points.data()),
+      static_cast<int>(hull_points.size()), sizeof(btVector3));
+  shape->setMargin(options.margin);
+
+  return shape;
+}
+
+std::unique_ptr<btCollisionShape> createConvexShape(
+    const Geometry& geometry, const ConvexHullOptions& options) {
+  if (options.max_hull_count <= 1) {
+    std::vector<btVector3> points;
+    for (auto& vertex : geometry.getVertices()) {
+      points.emplace_back(vertex.position.x, vertex.position.y,
+                          vertex.position.z);
+    }
+    return createConvexHullShape(points, options);
+  }
+
+  auto compound_shape = std::make_unique<ConvexDecompositionShape>();
+  for (auto& part : decomposeGeometry(geometry, options)) {
+    auto hull_shape = createConvexHullShape(
+        getTrianglePoints(geometry, part.triangles), options);
+    compound_shape->addChildShape(btTransform::getIdentity(),
+                                  hull_shape.get());
+    compound_shape->hulls.push_back(std::move(hull_shape));
+  }
+
+  return compound_shape;
+}
+
+}  // namespace
+
+ConvexHullPhysicsModule::ConvexHullPhysicsModule(
+    const Geometry& geometry, float mass, const btVector3& inertia,
+    const btTransform& transform, const ConvexHullOptions& options)
+    : PhysicsModule(getMassProperties(geometry, mass, inertia),
+                    getShape(geometry, options), transform) {}
+
+std::shared_ptr<btCollisionShape> ConvexHullPhysicsModule::getShape(
+    const Geometry& geometry, const ConvexHullOptions& options) {
+  return CollisionShapeCache::getShape(
+      {
+          .geometry_id = geometry.getId(),
+          .geometry_version = geometry.getVersion(),
+          .type = CollisionShapeType::CONVEX_HULL,
+          .parameters = {static_cast<float>(options.max_vertex_count),
+                         static_cast<float>(options.max_hull_count),
+                         options.min_concavity, options.margin},
+      },
+      [&]() { return createConvexShape(geometry, options); });
 }
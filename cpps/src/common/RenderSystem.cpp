@@ -27,3 +27,13 @@
 RenderSystem::~RenderSystem() {
   // Empty definition
 }
+
+uint64_t getRenderItemSortKey(ShaderProgramId shader_program_id,
+                              const VertexObject& vertex_object,
+                              size_t material_key) {
+  return (static_cast<uint64_t>(shader_program_id & 0xFFF) << 52) |
+         (static_cast<uint64_t>(vertex_object.vao_id & 0x7F) << 45) |
+         (static_cast<uint64_t>(vertex_object.index_type) << 44) |
+         (static_cast<uint64_t>(material_key & 0xFFFFF) << 24) |
+         static_cast<uint64_t>(vertex_object.first_index & 0xFFFFFF);
+}
@@ -24,6 +24,9 @@
 
 #include "./Root.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <map>
 #include <vector>
 
@@ -52,35 +55,251 @@ void Root::updateGpuResources() {
     auto& mesh_ptr = entity_ref.get().mesh;
     auto& mesh = *mesh_ptr;
 
-    if (mesh.needs_to_update) {
-      gpu_resource_manager->upsertUniformBuffer(&mesh);
-      mesh.needs_to_update = false;
-    }
-
     auto& geometry = mesh.geometry.get();
     if (geometry.needs_to_update) {
       gpu_resource_manager->upsertVertexObject(&geometry);
+      geometry.clearDirtyRanges();
       geometry.needs_to_update = false;
     }
 
+    // Geometries may be shared, so each mesh compares against the current
+    // decode rather than relying on the geometry's update flag
+    if (mesh.getPositionDecode() != geometry.getPositionDecode()) {
+      mesh.setPositionDecode(geometry.getPositionDecode());
+    }
+
+    if (mesh.needs_to_update) {
+      gpu_resource_manager->upsertUniformBuffer(&mesh);
+      mesh.needs_to_update = false;
+    }
+
     auto& material = mesh.material.get();
     if (material.needs_to_update) {
       gpu_resource_manager->upsertUniformBuffer(&material);
       material.needs_to_update = false;
     }
   }
+
+  gpu_resource_manager->flushUniformBuffers();
+}
+
+int Root::simulateDynamicsWorld(float delta_ms) {
+  physics_accumulator_ms += delta_ms;
+
+  int step_count = 0;
+  while (physics_accumulator_ms >= physics_time_step_ms &&
+         step_count < max_physics_steps_per_frame) {
+    scene_manager->stepDynamicsWorld(physics_time_step_ms);
+
+    physics_accumulator_ms -= physics_time_step_ms;
+    step_count++;
+  }
+
+  // Drop the backlog after a hitch instead of catching up over many frames
+  if (physics_accumulator_ms >= physics_time_step_ms) {
+    physics_accumulator_ms = std::fmod(physics_accumulator_ms,
+                                       physics_time_step_ms);
+  }
+
+  return step_count;
+}
+
+void Root::syncEntityMeshesWithPhysics(float alpha, bool has_stepped) {
+  // Only bodies Bullet pushed a transform for are visited
+  std::erase_if(scene_manager->moved_motion_states,
+                [alpha, has_stepped](MeshMotionState* motion_state) {
+                  return !motion_state->syncMesh(alpha, has_stepped);
+                });
+}
+
+// Levels step down each time the projected bounding sphere halves below
+// lod_screen_size
+static size_t selectLod(const Camera& camera, const Mesh& mesh,
+                        const Geometry& geometry, float lod_screen_size) {
+  size_t lod_count = geometry.getLodCount();
+  if (lod_count == 1 || lod_screen_size <= 0.f) {
+    return 0;
+  }
+
+  const glm::vec4& bounding_sphere = geometry.getBoundingSphere();
+  const glm::mat4& model_matrix = mesh.getModelMatrix();
+  const glm::mat4& projection_matrix = camera.getProjectionMatrix();
+
+  glm::vec4 view_center = camera.getViewMatrix() * model_matrix *
+                          glm::vec4(glm::vec3(bounding_sphere), 1.f);
+  float clip_w = (projection_matrix * view_center).w;
+  float scale = std::max({glm::length(glm::vec3(model_matrix[0])),
+                          glm::length(glm::vec3(model_matrix[1])),
+                          glm::length(glm::vec3(model_matrix[2]))});
+  float radius = bounding_sphere.w * scale;
+
+  // Spheres reaching the eye are as close as it gets
+  if (clip_w <= radius) {
+    return 0;
+  }
+
+  // Projected diameter, 2 * radius * P[1][1] / w, over the NDC height of 2
+  float screen_size = radius * projection_matrix[1][1] / clip_w;
+  if (screen_size >= lod_screen_size) {
+    return 0;
+  }
+
+  // Zero sizes and degenerate matrices would cast inf or NaN below
+  float halvings = std::log2(lod_screen_size / screen_size);
+  if (screen_size <= 0.f || !std::isfinite(halvings) ||
+      halvings >= static_cast<float>(lod_count - 1)) {
+    return lod_count - 1;
+  }
+
+  return static_cast<size_t>(halvings) + 1;
+}
+
+// Sort keys hold truncated fields, so equal keys are confirmed in full
+static bool canShareInstances(const RenderItem& lhs, const RenderItem& rhs) {
+  constexpr size_t material_index =
+      static_cast<size_t>(UniformBlockType::MATERIAL);
+
+  return lhs.sort_key == rhs.sort_key &&
+         lhs.shader_program_id == rhs.shader_program_id &&
+         lhs.vertex_object.vao_id == rhs.vertex_object.vao_id &&
+         lhs.vertex_object.index_type == rhs.vertex_object.index_type &&
+         lhs.vertex_object.first_index == rhs.vertex_object.first_index &&
+         lhs.uniform_buffer_bindings.ranges[material_index].offset ==
+             rhs.uniform_buffer_bindings.ranges[material_index].offset;
 }
 
-void Root::simulateDynamicsWorld(float delta_ms) {
-  scene_manager.get()->bt_dynamics_world.get()->stepSimulation(
-      delta_ms / 1000.f, 10);
+void Root::appendInstancedRenderItem(size_t begin, size_t end) {
+  RenderItem render_item = mesh_render_items[begin].first;
+  auto& material = mesh_render_items[begin].second->material.get();
+
+  // InstanceData replaces ModelBlock
+  render_item.shader_program_id =
+      gpu_resource_manager->getShaderProgram(material.getType(), true);
+  render_item.uniform_buffer_bindings.mask &=
+      ~(1u << static_cast<unsigned int>(UniformBlockType::MODEL));
+  render_item.instance_count = static_cast<unsigned int>(end - begin);
+  render_item.instance_offset = instance_data.size() * sizeof(InstanceData);
+  render_item.sort_key = getRenderItemSortKey(
+      render_item.shader_program_id, render_item.vertex_object,
+      render_item.uniform_buffer_bindings
+              .ranges[static_cast<size_t>(UniformBlockType::MATERIAL)]
+              .offset /
+          UNIFORM_BLOCK_SIZE_ALIGNMENT);
+
+  for (size_t i = begin; i < end; i++) {
+    auto& mesh = *mesh_render_items[i].second;
+    instance_data.push_back({
+        .model_matrix = mesh.getModelMatrix(),
+        .position_decode = mesh.getPositionDecode(),
+    });
+  }
+
+  render_queue.push_back(render_item);
 }
 
-void Root::syncEntityMeshesWithPhysics() {
+void Root::buildRenderQueue() {
+  mesh_render_items.clear();
+  instance_data.clear();
+  render_queue.clear();
+  lod_triangle_counts = {};
+
+  auto& camera = scene_manager->camera.get();
+
+  // Scene-wide blocks are shared by every draw of the frame
+  UniformBufferBindings scene_bindings = {};
+  auto& scene_ranges = scene_bindings.ranges;
+  scene_ranges[static_cast<size_t>(UniformBlockType::CAMERA)] =
+      gpu_resource_manager->getUniformBufferRange(&camera);
+  scene_ranges[static_cast<size_t>(UniformBlockType::AMBIENT_LIGHT)] =
+      gpu_resource_manager->getUniformBufferRange(
+          &scene_manager->ambient_light.get());
+  scene_ranges[static_cast<size_t>(UniformBlockType::DIRECTIONAL_LIGHT)] =
+      gpu_resource_manager->getUniformBufferRange(
+          &scene_manager->directional_light.get());
+
   for (auto& entity_ref : scene_manager->getEntities()) {
-    auto& entity = entity_ref.get();
-    entity.syncMeshWithPhysics();
+    auto& mesh_ptr = entity_ref.get().mesh;
+    auto& mesh = *mesh_ptr;
+    auto& material = mesh.material.get();
+    auto& geometry = mesh.geometry.get();
+
+    size_t lod = selectLod(camera, mesh, geometry, lod_screen_size);
+    RenderItem render_item = {
+        .shader_program_id =
+            gpu_resource_manager->getShaderProgram(material.getType()),
+        .vertex_object = gpu_resource_manager->getVertexObject(&geometry, lod),
+        .uniform_buffer_bindings = scene_bindings,
+    };
+    lod_triangle_counts[lod] += render_item.vertex_object.vertex_count / 3;
+
+    auto& bindings = render_item.uniform_buffer_bindings;
+    bindings.mask = getUniformBlockMask(material.getType());
+    bindings.ranges[static_cast<size_t>(UniformBlockType::MODEL)] =
+        gpu_resource_manager->getUniformBufferRange(&mesh);
+    bindings.ranges[static_cast<size_t>(UniformBlockType::MATERIAL)] =
+        gpu_resource_manager->getUniformBufferRange(&material);
+
+    // Materials are told apart by their slot in the uniform arena
+    render_item.sort_key = getRenderItemSortKey(
+        render_item.shader_program_id, render_item.vertex_object,
+        bindings.ranges[static_cast<size_t>(UniformBlockType::MATERIAL)]
+                .offset /
+            UNIFORM_BLOCK_SIZE_ALIGNMENT);
+
+    mesh_render_items.push_back({render_item, &mesh});
   }
+
+  std::sort(mesh_render_items.begin(), mesh_render_items.end(),
+            [](const auto& lhs, const auto& rhs) {
+              return lhs.first.sort_key < rhs.first.sort_key;
+            });
+
+  // Equal program, geometry and material means a long enough run differs
+  // only in its model matrices. Multi-draw batches need every
+  // mesh in the instance buffer, so any run length qualifies there
+  size_t instance_threshold = static_cast<size_t>(min_instance_count);
+  if (min_instance_count > 0 && render_system->isMultiDrawSupported()) {
+    instance_threshold = 1;
+  }
+
+  size_t run_begin = 0;
+  while (run_begin < mesh_render_items.size()) {
+    size_t run_end = run_begin + 1;
+    while (run_end < mesh_render_items.size() &&
+           canShareInstances(mesh_render_items[run_begin].first,
+                             mesh_render_items[run_end].first)) {
+      run_end++;
+    }
+
+    if (instance_threshold > 0 && run_end - run_begin >= instance_threshold) {
+      appendInstancedRenderItem(run_begin, run_end);
+    } else {
+      for (size_t i = run_begin; i < run_end; i++) {
+        render_queue.push_back(mesh_render_items[i].first);
+      }
+    }
+
+    run_begin = run_end;
+  }
+
+  if (!instance_data.empty()) {
+    gpu_resource_manager->uploadInstanceData(
+        instance_data.data(), instance_data.size() * sizeof(InstanceData));
+
+    InstanceBufferId instance_buffer_id =
+        gpu_resource_manager->getInstanceBufferId();
+    for (auto& render_item : render_queue) {
+      if (render_item.instance_count > 0) {
+        render_item.instance_buffer_id = instance_buffer_id;
+      }
+    }
+  }
+
+  // Instanced programs have their own ids, so the merged queue is re-sorted
+  std::sort(render_queue.begin(), render_queue.end(),
+            [](const RenderItem& lhs, const RenderItem& rhs) {
+              return lhs.sort_key < rhs.sort_key;
+            });
 }
 
 void Root::renderScene(const std::function<void(float, float)>& loop_func) {
@@ -88,65 +307,26 @@ void Root::renderScene(const std::function<void(float, float)>& loop_func) {
                                         float delta_ms) -> void {
     loop_func(elapsed_ms, delta_ms);
 
-    simulateDynamicsWorld(delta_ms);
-    syncEntityMeshesWithPhysics();
+    int step_count = simulateDynamicsWorld(delta_ms);
+    syncEntityMeshesWithPhysics(physics_accumulator_ms / physics_time_step_ms,
+                                step_count > 0);
 
+    gpu_resource_manager->beginFrame();
     updateGpuResources();
 
-    auto camera_uniform_buffer_id =
-        gpu_resource_manager->getUniformBufferId(&scene_manager->camera.get());
-    auto ambient_light_uniform_buffer_id =
-        gpu_resource_manager->getUniformBufferId(
-            &scene_manager->ambient_light.get());
-    auto directional_light_uniform_buffer_id =
-        gpu_resource_manager->getUniformBufferId(
-            &scene_manager->directional_light.get());
-
-    for (auto& entity_ref : scene_manager->getEntities()) {
-      auto& mesh_ptr = entity_ref.get().mesh;
-      auto& mesh = *mesh_ptr;
-
-      ShaderProgramId shader_program_id =
-          gpu_resource_manager->getShaderProgram(mesh.material.get().getType());
-      auto& vertex_object =
-          gpu_resource_manager->getVertexObject(&mesh.geometry.get());
-
-      auto uniform_block_types =
-          getUniformBlockTypes(mesh.material.get().getType());
-
-      std::unordered_map<UniformBlockType, unsigned int> uniform_buffer_map;
-
-      for (auto& uniform_buffer_type : uniform_block_types) {
-        switch (uniform_buffer_type) {
-          case UniformBlockType::CAMERA:
-            uniform_buffer_map[uniform_buffer_type] = camera_uniform_buffer_id;
-            break;
-          case UniformBlockType::MODEL:
-            uniform_buffer_map[uniform_buffer_type] =
-                gpu_resource_manager->getUniformBufferId(&mesh);
-            break;
-          case UniformBlockType::MATERIAL:
-            uniform_buffer_map[uniform_buffer_type] =
-                gpu_resource_manager->getUniformBufferId(&mesh.material.get());
-            break;
-          case UniformBlockType::AMBIENT_LIGHT:
-            uniform_buffer_map[uniform_buffer_type] =
-                ambient_light_uniform_buffer_id;
-            break;
-          case UniformBlockType::DIRECTIONAL_LIGHT:
-            uniform_buffer_map[uniform_buffer_type] =
-                directional_light_uniform_buffer_id;
-            break;
-          default:
-            throw std::runtime_error(
-                "You should define the uniform block types for the material "
-                "type.");
-        }
-      }
+    auto submission_start = std::chrono::steady_clock::now();
 
-      render_system->drawTriangles(shader_program_id, vertex_object,
-                                   uniform_buffer_map);
-    }
+    buildRenderQueue();
+    render_statistics = render_system->drawRenderItems(
+        render_queue, gpu_resource_manager->getFrameIndex());
+    render_statistics.lod_triangle_counts = lod_triangle_counts;
+
+    render_statistics.submission_ms =
+        std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - submission_start)
+            .count();
+
+    gpu_resource_manager->endFrame();
   };
 
   render_system->runRenderLoop(renderItems);
@@ -24,25 +24,79 @@
 
 #include "./SceneManager.h"
 
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <LinearMath/btThreads.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+// Bullet keeps one global scheduler for every multithreaded world, so the
+// last scene created sets its thread count. Returns nullptr when Bullet was
+// built without BT_THREADSAFE.
+btITaskScheduler* getTaskScheduler() {
+  // A thread pool on pthreads, or Win32 threads on Windows
+  static std::unique_ptr<btITaskScheduler> task_scheduler = []() {
+    std::unique_ptr<btITaskScheduler> scheduler(btCreateDefaultTaskScheduler());
+    if (scheduler != nullptr) {
+      btSetTaskScheduler(scheduler.get());
+    }
+    return scheduler;
+  }();
+
+  return task_scheduler.get();
+}
+
+}  // namespace
 
 SceneManager::SceneManager(
     std::reference_wrapper<Camera> camera,
     std::reference_wrapper<AmbientLight> ambient_light,
-    std::reference_wrapper<DirectionalLight> directional_light)
+    std::reference_wrapper<DirectionalLight> directional_light,
+    const SceneManagerOptions& options)
     : camera(camera),
       ambient_light(ambient_light),
-      directional_light(directional_light) {
+      directional_light(directional_light),
+      settle_detector(options.settle_detector_options) {
+  unsigned int thread_count = options.physics_thread_count > 0
+                                  ? options.physics_thread_count
+                                  : std::thread::hardware_concurrency();
+  btITaskScheduler* task_scheduler =
+      thread_count > 1 ? getTaskScheduler() : nullptr;
+
   bt_broadphase = std::make_unique<btDbvtBroadphase>();
   bt_collision_configuration =
       std::make_unique<btDefaultCollisionConfiguration>();
-  bt_dispatcher =
-      std::make_unique<btCollisionDispatcher>(bt_collision_configuration.get());
-  btGImpactCollisionAlgorithm::registerAlgorithm(bt_dispatcher.get());
-  bt_solver = std::make_unique<btSequentialImpulseConstraintSolver>();
-  bt_dynamics_world = std::make_unique<btDiscreteDynamicsWorld>(
-      bt_dispatcher.get(), bt_broadphase.get(), bt_solver.get(),
-      bt_collision_configuration.get());
+
+  if (task_scheduler != nullptr) {
+    physics_thread_count = std::min<unsigned int>(
+        thread_count, task_scheduler->getMaxNumThreads());
+    task_scheduler->setNumThreads(physics_thread_count);
+
+    bt_dispatcher = std::make_unique<btCollisionDispatcherMt>(
+        bt_collision_configuration.get());
+    btGImpactCollisionAlgorithm::registerAlgorithm(bt_dispatcher.get());
+
+    auto solver_pool =
+        std::make_unique<btConstraintSolverPoolMt>(physics_thread_count);
+    bt_solver_mt = std::make_unique<btSequentialImpulseConstraintSolverMt>();
+    bt_dynamics_world = std::make_unique<btDiscreteDynamicsWorldMt>(
+        bt_dispatcher.get(), bt_broadphase.get(), solver_pool.get(),
+        bt_solver_mt.get(), bt_collision_configuration.get());
+    bt_solver = std::move(solver_pool);
+  } else {
+    bt_dispatcher = std::make_unique<btCollisionDispatcher>(
+        bt_collision_configuration.get());
+    btGImpactCollisionAlgorithm::registerAlgorithm(bt_dispatcher.get());
+    bt_solver = std::make_unique<btSequentialImpulseConstraintSolver>();
+    bt_dynamics_world = std::make_unique<btDiscreteDynamicsWorld>(
+        bt_dispatcher.get(), bt_broadphase.get(), bt_solver.get(),
+        bt_collision_configuration.get());
+  }
 
   bt_dynamics_world.get()->setGravity(btVector3(0, -9.81, 0));  // Set gravity
 }
@@ -52,5 +106,12 @@ void SceneManager::addEntity(std::reference_wrapper<Entity> entity) {
   auto rigid_body = (*physics_module).getRigidBody();
 
   entities.push_back(entity);
+  physics_module->bindMesh(*entity.get().mesh, moved_motion_states);
   bt_dynamics_world.get()->addRigidBody(&rigid_body.get());
 }
+
+void SceneManager::stepDynamicsWorld(float time_step_ms) {
+  // Zero substeps disables Bullet's own accumulator and interpolation
+  bt_dynamics_world.get()->stepSimulation(time_step_ms / 1000.f, 0);
+  settle_detector.update();
+}
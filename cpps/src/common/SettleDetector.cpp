@@ -0,0 +1,145 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./SettleDetector.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+void SettleDetector::registerFaceNormals(const Geometry& geometry,
+                                         std::vector<glm::vec3> face_normals) {
+  this->face_normals[&geometry] = std::move(face_normals);
+}
+
+void SettleDetector::watch(
+    Entity& entity, std::function<void(const SettleEvent&)> on_settled) {
+  if (!face_normals.contains(&entity.mesh->geometry.get())) {
+    throw std::runtime_error("No face normals registered for the geometry");
+  }
+
+  unwatch(entity);
+  watched_entities.push_back({entity, std::move(on_settled)});
+  rolling_count++;
+}
+
+void SettleDetector::unwatch(const Entity& entity) {
+  auto it = std::find_if(watched_entities.begin(), watched_entities.end(),
+                         [&](const WatchedEntity& watched_entity) {
+                           return &watched_entity.entity.get() == &entity;
+                         });
+  if (it == watched_entities.end()) {
+    return;
+  }
+
+  if (!it->is_settled) {
+    rolling_count--;
+  }
+  watched_entities.erase(it);
+}
+
+void SettleDetector::reset() {
+  for (auto& watched_entity : watched_entities) {
+    watched_entity.step_count = 0;
+    watched_entity.still_step_count = 0;
+    watched_entity.is_settled = false;
+  }
+  rolling_count = watched_entities.size();
+}
+
+void SettleDetector::update() {
+  if (rolling_count == 0) {
+    return;
+  }
+
+  // Fired after the loop, so callbacks may watch or unwatch entities
+  std::vector<std::pair<std::function<void(const SettleEvent&)>, SettleEvent>>
+      events;
+
+  for (auto& watched_entity : watched_entities) {
+    if (watched_entity.is_settled) {
+      continue;
+    }
+
+    Entity& entity = watched_entity.entity.get();
+    const btRigidBody& rigid_body = entity.physics_module->getRigidBody().get();
+
+    watched_entity.step_count++;
+    if (!rigid_body.isActive() || rigid_body.isStaticOrKinematicObject()) {
+      watched_entity.still_step_count = options.rest_step_count;
+    } else if (isStill(entity)) {
+      watched_entity.still_step_count++;
+    } else {
+      watched_entity.still_step_count = 0;
+    }
+
+    if (watched_entity.still_step_count < options.rest_step_count) {
+      continue;
+    }
+
+    watched_entity.is_settled = true;
+    rolling_count--;
+
+    if (watched_entity.on_settled) {
+      events.emplace_back(watched_entity.on_settled,
+                          SettleEvent{
+                              .entity = entity,
+                              .face = getUpwardFace(entity),
+                              .step_count = watched_entity.step_count,
+                          });
+    }
+  }
+
+  for (auto& [on_settled, event] : events) {
+    on_settled(event);
+  }
+}
+
+int SettleDetector::getUpwardFace(const Entity& entity) const {
+  const auto& normals = face_normals.at(&entity.mesh->geometry.get());
+  glm::quat rotation = entity.physics_module->getRotation();
+
+  int upward_face = -1;
+  float max_height = -2.f;
+  for (size_t i = 0; i < normals.size(); i++) {
+    float height = glm::dot(rotation * normals[i], options.up);
+    if (height > max_height) {
+      max_height = height;
+      upward_face = static_cast<int>(i);
+    }
+  }
+
+  return upward_face;
+}
+
+bool SettleDetector::isStill(const Entity& entity) const {
+  const btRigidBody& rigid_body = entity.physics_module->getRigidBody().get();
+  float linear_threshold = options.linear_velocity_threshold;
+  float angular_threshold = options.angular_velocity_threshold;
+
+  return rigid_body.getLinearVelocity().length2() <
+             linear_threshold * linear_threshold &&
+         rigid_body.getAngularVelocity().length2() <
+             angular_threshold * angular_threshold;
+}
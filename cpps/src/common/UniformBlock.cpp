@@ -24,6 +24,8 @@
 
 #include "./UniformBlock.h"
 
+#include <array>
+
 std::string getUniformBlockName(UniformBlockType type) {
   switch (type) {
     case UniformBlockType::CAMERA:
@@ -62,3 +64,19 @@ std::vector<UniformBlockType> getUniformBlockTypes(MaterialType material_type) {
           "You should define the uniform block types for the material type.");
   }
 }
+
+UniformBlockMask getUniformBlockMask(MaterialType material_type) {
+  // Built once, so looking up a mask while drawing never allocates
+  static const std::array<UniformBlockMask, MATERIAL_TYPE_COUNT> masks = [] {
+    std::array<UniformBlockMask, MATERIAL_TYPE_COUNT> masks = {};
+    for (size_t i = 0; i < MATERIAL_TYPE_COUNT; i++) {
+      for (auto& block_type :
+           getUniformBlockTypes(static_cast<MaterialType>(i))) {
+        masks[i] |= 1u << static_cast<size_t>(block_type);
+      }
+    }
+    return masks;
+  }();
+
+  return masks[static_cast<size_t>(material_type)];
+}
@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "./GeometryUtils.h"
+#include "./MeshCache.h"
+
+// Imports an OBJ with the same processing as at runtime and writes the
+// result as a mesh cache. With --require-lods, fails unless the model gets
+// at least one coarser level.
+int main(int argc, char** argv) {
+  bool is_lod_required = argc == 4 && std::string(argv[3]) == "--require-lods";
+  if (argc != 3 && !is_lod_required) {
+    std::cerr << "Usage: " << argv[0]
+              << " <input.obj> <output.mesh> [--require-lods]" << std::endl;
+    return 1;
+  }
+
+  std::string obj_path = argv[1];
+  std::string mesh_cache_path = argv[2];
+
+  try {
+    Geometry geometry = GeometryUtils::loadObjToGeometry(obj_path);
+
+    std::cout << obj_path << ": " << geometry.getVertices().size()
+              << " vertices, triangles per LOD";
+    for (size_t lod = 0; lod < geometry.getLodCount(); lod++) {
+      std::cout << " " << geometry.getLodIndices(lod).size() / 3;
+    }
+    std::cout << std::endl;
+
+    if (is_lod_required && geometry.getLodCount() < 2) {
+      throw std::runtime_error(obj_path + " produced no coarser LOD");
+    }
+
+    MeshCache::save(mesh_cache_path, geometry);
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
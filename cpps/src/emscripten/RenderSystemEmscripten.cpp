@@ -24,6 +24,8 @@
 
 #include "./RenderSystemEmscripten.h"
 
+#include "./render_state.h"
+
 // Store the std::function in a static/global variable
 static std::function<void(float, float)> stored_function;
 static double start_time = emscripten_get_now();
@@ -83,24 +85,55 @@ void RenderSystemEmscripten::runRenderLoop(
   emscripten_set_main_loop(render_frame, 0, 1);
 }
 
-void RenderSystemEmscripten::drawTriangles(
-    ShaderProgramId shader_program_id, const VertexObject& vertex_object,
-    const std::unordered_map<UniformBlockType, unsigned int>
-        uniform_buffer_map) {
-  glUseProgram(shader_program_id);
-  glBindVertexArray(vertex_object.vao_id);
-
-  int uniform_binging_point = 0;
-  for (auto& [block_type, buffer_id] : uniform_buffer_map) {
-    glBindBufferBase(GL_UNIFORM_BUFFER, uniform_binging_point, buffer_id);
-    unsigned int block_index = glGetUniformBlockIndex(
-        shader_program_id, getUniformBlockName(block_type).c_str());
-    glUniformBlockBinding(shader_program_id, block_index,
-                          uniform_binging_point);
-    uniform_binging_point++;
+RenderStatistics RenderSystemEmscripten::drawRenderItems(
+    const std::vector<RenderItem>& render_items,
+    [[maybe_unused]] int frame_index) {
+  RenderStatistics statistics = {};
+
+  ShaderProgramId bound_shader_program_id = 0;
+  unsigned int bound_vao_id = 0;
+  std::array<UniformBufferRange, UNIFORM_BLOCK_TYPE_COUNT> bound_ranges = {};
+
+  for (auto& render_item : render_items) {
+    if (render_item.shader_program_id != bound_shader_program_id) {
+      glUseProgram(render_item.shader_program_id);
+      bound_shader_program_id = render_item.shader_program_id;
+      statistics.shader_program_change_count++;
+    }
+
+    if (render_item.vertex_object.vao_id != bound_vao_id) {
+      glBindVertexArray(render_item.vertex_object.vao_id);
+      bound_vao_id = render_item.vertex_object.vao_id;
+      statistics.vertex_array_change_count++;
+    }
+
+    bindUniformBufferRanges(render_item.uniform_buffer_bindings, bound_ranges,
+                            statistics);
+
+    auto& vertex_object = render_item.vertex_object;
+    GLenum index_type = getIndexGlType(vertex_object.index_type);
+    void* index_offset =
+        reinterpret_cast<void*>(getIndexByteOffset(vertex_object));
+
+    if (render_item.instance_count == 0) {
+      glDrawElements(GL_TRIANGLES, vertex_object.vertex_count, index_type,
+                     index_offset);
+      statistics.draw_count++;
+      statistics.instance_count++;
+      continue;
+    }
+
+    bindInstanceData(render_item.instance_buffer_id,
+                     render_item.instance_offset);
+
+    glDrawElementsInstanced(GL_TRIANGLES, vertex_object.vertex_count,
+                            index_type, index_offset,
+                            render_item.instance_count);
+    statistics.draw_count++;
+    statistics.instance_count += render_item.instance_count;
   }
 
-  glDrawElements(GL_TRIANGLES, vertex_object.vertex_count, GL_UNSIGNED_INT, 0);
+  return statistics;
 }
 
 void RenderSystemEmscripten::setClearColor(const glm::vec4& color) {
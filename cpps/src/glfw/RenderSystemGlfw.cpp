@@ -24,19 +24,28 @@
 
 #include "./RenderSystemGlfw.h"
 
+#include <algorithm>
+
+#include "./render_state.h"
+
 RenderSystemGlfw::RenderSystemGlfw(int width, int height) {
   // Initialize GLFW
   if (!glfwInit()) {
     throw std::runtime_error("Failed to initialize GLFW!");
   }
 
-  // Set GLFW window properties
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  // Set GLFW window properties; prefer 4.3 for multi-draw indirect
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
   // Create a GLFW window
   window = glfwCreateWindow(width, height, "Dice", nullptr, nullptr);
+  if (!window) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    window = glfwCreateWindow(width, height, "Dice", nullptr, nullptr);
+  }
   if (!window) {
     glfwTerminate();
     throw std::runtime_error("Failed to create GLFW window!");
@@ -49,10 +58,19 @@ RenderSystemGlfw::RenderSystemGlfw(int width, int height) {
     throw std::runtime_error("Failed to initialize GLAD!");
   }
 
+  is_multi_draw_indirect_supported = GLAD_GL_VERSION_4_3 != 0;
+  if (is_multi_draw_indirect_supported) {
+    glGenBuffers(FRAMES_IN_FLIGHT, indirect_buffer_ids.data());
+  }
+
   glEnable(GL_DEPTH_TEST);
 }
 
 RenderSystemGlfw::~RenderSystemGlfw() {
+  if (is_multi_draw_indirect_supported) {
+    glDeleteBuffers(FRAMES_IN_FLIGHT, indirect_buffer_ids.data());
+  }
+
   glfwDestroyWindow(window);
   glfwTerminate();
 }
@@ -88,24 +106,179 @@ void RenderSystemGlfw::runRenderLoop(
   }
 }
 
-void RenderSystemGlfw::drawTriangles(
-    ShaderProgramId shader_program_id, const VertexObject& vertex_object,
-    const std::unordered_map<UniformBlockType, unsigned int>
-        uniform_buffer_map) {
-  glUseProgram(shader_program_id);
-  glBindVertexArray(vertex_object.vao_id);
-
-  int uniform_binging_point = 0;
-  for (auto& [block_type, buffer_id] : uniform_buffer_map) {
-    glBindBufferBase(GL_UNIFORM_BUFFER, uniform_binging_point, buffer_id);
-    unsigned int block_index = glGetUniformBlockIndex(
-        shader_program_id, getUniformBlockName(block_type).c_str());
-    glUniformBlockBinding(shader_program_id, block_index,
-                          uniform_binging_point);
-    uniform_binging_point++;
+// Items in one indirect batch must agree on every piece of bound state
+static bool canShareMultiDraw(const RenderItem& lhs, const RenderItem& rhs) {
+  if (lhs.instance_count == 0 || rhs.instance_count == 0 ||
+      lhs.shader_program_id != rhs.shader_program_id ||
+      lhs.vertex_object.vao_id != rhs.vertex_object.vao_id ||
+      lhs.vertex_object.index_type != rhs.vertex_object.index_type ||
+      lhs.instance_buffer_id != rhs.instance_buffer_id ||
+      lhs.uniform_buffer_bindings.mask != rhs.uniform_buffer_bindings.mask) {
+    return false;
+  }
+
+  for (size_t i = 0; i < UNIFORM_BLOCK_TYPE_COUNT; i++) {
+    if ((lhs.uniform_buffer_bindings.mask & (1u << i)) != 0 &&
+        !isSameUniformRange(lhs.uniform_buffer_bindings.ranges[i],
+                            rhs.uniform_buffer_bindings.ranges[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+RenderStatistics RenderSystemGlfw::drawRenderItems(
+    const std::vector<RenderItem>& render_items, int frame_index) {
+  if (is_multi_draw_indirect_supported) {
+    return drawRenderItemsIndirect(render_items, frame_index);
+  }
+
+  RenderStatistics statistics = {};
+
+  ShaderProgramId bound_shader_program_id = 0;
+  unsigned int bound_vao_id = 0;
+  std::array<UniformBufferRange, UNIFORM_BLOCK_TYPE_COUNT> bound_ranges = {};
+
+  for (auto& render_item : render_items) {
+    if (render_item.shader_program_id != bound_shader_program_id) {
+      glUseProgram(render_item.shader_program_id);
+      bound_shader_program_id = render_item.shader_program_id;
+      statistics.shader_program_change_count++;
+    }
+
+    if (render_item.vertex_object.vao_id != bound_vao_id) {
+      glBindVertexArray(render_item.vertex_object.vao_id);
+      bound_vao_id = render_item.vertex_object.vao_id;
+      statistics.vertex_array_change_count++;
+    }
+
+    bindUniformBufferRanges(render_item.uniform_buffer_bindings, bound_ranges,
+                            statistics);
+
+    auto& vertex_object = render_item.vertex_object;
+    GLenum index_type = getIndexGlType(vertex_object.index_type);
+    void* index_offset =
+        reinterpret_cast<void*>(getIndexByteOffset(vertex_object));
+
+    if (render_item.instance_count == 0) {
+      glDrawElementsBaseVertex(GL_TRIANGLES, vertex_object.vertex_count,
+                               index_type, index_offset,
+                               vertex_object.base_vertex);
+      statistics.draw_count++;
+      statistics.instance_count++;
+      continue;
+    }
+
+    bindInstanceData(render_item.instance_buffer_id,
+                     render_item.instance_offset);
+
+    glDrawElementsInstancedBaseVertex(
+        GL_TRIANGLES, vertex_object.vertex_count, index_type, index_offset,
+        render_item.instance_count, vertex_object.base_vertex);
+    statistics.draw_count++;
+    statistics.instance_count += render_item.instance_count;
+  }
+
+  return statistics;
+}
+
+RenderStatistics RenderSystemGlfw::drawRenderItemsIndirect(
+    const std::vector<RenderItem>& render_items, int frame_index) {
+  RenderStatistics statistics = {};
+
+  // One command per item, uploaded once; batches index into the buffer
+  draw_commands.clear();
+  for (auto& render_item : render_items) {
+    draw_commands.push_back({
+        .count = render_item.vertex_object.vertex_count,
+        .instance_count = render_item.instance_count,
+        .first_index = render_item.vertex_object.first_index,
+        .base_vertex = render_item.vertex_object.base_vertex,
+        .base_instance = static_cast<GLuint>(render_item.instance_offset /
+                                             sizeof(InstanceData)),
+    });
+  }
+
+  if (draw_commands.size() > indirect_buffer_capacity) {
+    indirect_buffer_capacity =
+        std::max(draw_commands.size(), indirect_buffer_capacity * 2);
+    for (auto indirect_buffer_id : indirect_buffer_ids) {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_id);
+      glBufferData(
+          GL_DRAW_INDIRECT_BUFFER,
+          indirect_buffer_capacity * sizeof(DrawElementsIndirectCommand),
+          nullptr, GL_DYNAMIC_DRAW);
+    }
+  }
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_ids[frame_index]);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                  draw_commands.size() * sizeof(DrawElementsIndirectCommand),
+                  draw_commands.data());
+
+  ShaderProgramId bound_shader_program_id = 0;
+  unsigned int bound_vao_id = 0;
+  std::array<UniformBufferRange, UNIFORM_BLOCK_TYPE_COUNT> bound_ranges = {};
+
+  size_t batch_begin = 0;
+  while (batch_begin < render_items.size()) {
+    auto& render_item = render_items[batch_begin];
+
+    size_t batch_end = batch_begin + 1;
+    while (batch_end < render_items.size() &&
+           canShareMultiDraw(render_item, render_items[batch_end])) {
+      batch_end++;
+    }
+
+    if (render_item.shader_program_id != bound_shader_program_id) {
+      glUseProgram(render_item.shader_program_id);
+      bound_shader_program_id = render_item.shader_program_id;
+      statistics.shader_program_change_count++;
+    }
+
+    if (render_item.vertex_object.vao_id != bound_vao_id) {
+      glBindVertexArray(render_item.vertex_object.vao_id);
+      bound_vao_id = render_item.vertex_object.vao_id;
+      statistics.vertex_array_change_count++;
+    }
+
+    bindUniformBufferRanges(render_item.uniform_buffer_bindings, bound_ranges,
+                            statistics);
+
+    if (render_item.instance_count == 0) {
+      auto& vertex_object = render_item.vertex_object;
+      glDrawElementsBaseVertex(
+          GL_TRIANGLES, vertex_object.vertex_count,
+          getIndexGlType(vertex_object.index_type),
+          reinterpret_cast<void*>(getIndexByteOffset(vertex_object)),
+          vertex_object.base_vertex);
+      statistics.draw_count++;
+      statistics.instance_count++;
+      batch_begin = batch_end;
+      continue;
+    }
+
+    // Instance data is addressed from byte 0 so that each indirect command
+    // can select its own through base_instance
+    bindInstanceData(render_item.instance_buffer_id, 0);
+
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, getIndexGlType(render_item.vertex_object.index_type),
+        reinterpret_cast<void*>(batch_begin *
+                                sizeof(DrawElementsIndirectCommand)),
+        static_cast<GLsizei>(batch_end - batch_begin), 0);
+    statistics.draw_count++;
+    for (size_t i = batch_begin; i < batch_end; i++) {
+      statistics.instance_count += render_items[i].instance_count;
+    }
+
+    batch_begin = batch_end;
   }
 
-  glDrawElements(GL_TRIANGLES, vertex_object.vertex_count, GL_UNSIGNED_INT, 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  return statistics;
 }
 
 void RenderSystemGlfw::setClearColor(const glm::vec4& color) {
@@ -28,10 +28,17 @@
 #include "./RenderSystemGlfw.h"
 #include "./SceneManager.h"
 
-Root::Root(const RootOptions& options) {
+Root::Root(const RootOptions& options)
+    : physics_time_step_ms(1000.f / options.physics_tick_rate),
+      max_physics_steps_per_frame(options.max_physics_steps_per_frame),
+      min_instance_count(options.min_instance_count),
+      lod_screen_size(options.lod_screen_size) {
   render_system = std::make_unique<RenderSystemGlfw>(options.initial_width,
                                                      options.initial_height);
   gpu_resource_manager = std::make_unique<GpuResourceManagerOpenGL>();
   scene_manager = std::make_unique<SceneManager>(
-      options.camera, options.ambient_light, options.directional_light);
+      options.camera, options.ambient_light, options.directional_light,
+      SceneManagerOptions{
+          .physics_thread_count = options.physics_thread_count,
+      });
 }
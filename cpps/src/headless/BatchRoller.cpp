@@ -0,0 +1,190 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./BatchRoller.h"
+
+#include <btBulletDynamicsCommon.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "./Camera.h"
+#include "./Entity.h"
+#include "./Geometry.h"
+#include "./HeadlessRoot.h"
+#include "./Light.h"
+#include "./Material.h"
+#include "./Mesh.h"
+#include "./PhysicsModule.h"
+
+namespace {
+
+void rollOnWorker(const BatchRollerOptions& options,
+                  const std::vector<RollRequest>& requests,
+                  std::vector<RollResult>& results,
+                  std::atomic<size_t>& next_index) {
+  // The scene manager still expects a camera and lights; they are never used
+  Camera camera;
+  AmbientLight ambient_light(0.f, glm::vec3(0.f));
+  DirectionalLight directional_light(0.f, glm::vec3(0.f), glm::vec3(0.f));
+
+  CubeGeometry die_geometry(options.die_half_size, options.die_half_size,
+                            options.die_half_size);
+  PlaneGeometry floor_geometry(4.0f, 4.0f);
+  BasicMaterial basic_material;
+
+  btTransform die_transform(btQuaternion(0, 0, 0, 1), btVector3(0, 0, 0));
+  std::unique_ptr<PhysicsModule> die_physics_module;
+  switch (options.die_shape) {
+    case DieShape::CONVEX_HULL:
+      die_physics_module = std::make_unique<ConvexHullPhysicsModule>(
+          die_geometry, options.die_mass, btVector3(0, 0, 0), die_transform);
+      break;
+    case DieShape::TRIANGLE_MESH:
+      die_physics_module = std::make_unique<TriangleMeshPhysicsModule>(
+          die_geometry, options.die_mass, btVector3(0, 0, 0), die_transform);
+      break;
+    default:
+      die_physics_module = std::make_unique<BoxShapePhysicsModule>(
+          options.die_mass, btVector3(0, 0, 0), die_geometry, die_transform);
+      break;
+  }
+
+  std::unique_ptr<btCollisionShape> floor_collision_shape =
+      std::make_unique<btBoxShape>(btBoxShape(btVector3(4.0f, 4.0f, 0.01f)));
+  floor_collision_shape->setMargin(0.04f);
+
+  std::unique_ptr<PhysicsModule> floor_physics_module =
+      std::make_unique<PhysicsModule>(
+          0.f, btVector3(0, 0, 0), std::move(floor_collision_shape),
+          btTransform(btQuaternion(btVector3(1, 0, 0), glm::radians(-90.0f)),
+                      btVector3(0, options.floor_height, 0)));
+
+  Entity die_entity(std::make_unique<Mesh>(die_geometry, basic_material),
+                    std::move(die_physics_module));
+  Entity floor_entity(std::make_unique<Mesh>(floor_geometry, basic_material),
+                      std::move(floor_physics_module));
+
+  // Declared after the entities so the dynamics world is torn down while
+  // their rigid bodies are still alive
+  HeadlessRoot root({camera, ambient_light, directional_light,
+                     options.time_step_ms, options.max_steps_per_roll});
+
+  root.scene_manager->addEntity(die_entity);
+  root.scene_manager->addEntity(floor_entity);
+
+  auto& physics_module = *die_entity.physics_module;
+  auto& settle_detector = root.scene_manager->settle_detector;
+
+  bool is_settled = false;
+  settle_detector.registerFaceNormals(die_geometry,
+                                      CubeGeometry::getFaceNormals());
+  settle_detector.watch(die_entity,
+                        [&](const SettleEvent&) { is_settled = true; });
+
+  for (size_t index = next_index++; index < requests.size();
+       index = next_index++) {
+    const RollRequest& request = requests[index];
+
+    physics_module.setPosition(request.position);
+    physics_module.setRotation(request.rotation);
+    physics_module.setLinearVelocity(request.linear_velocity);
+    physics_module.setAngularVelocity(request.angular_velocity);
+
+    is_settled = false;
+    int step_count = root.simulateRoll();
+
+    results[index] = {
+        .seed = request.seed,
+        .face = settle_detector.getUpwardFace(die_entity),
+        .step_count = step_count,
+        .settled = is_settled,
+    };
+  }
+}
+
+}  // namespace
+
+std::vector<RollResult> BatchRoller::roll(
+    const std::vector<RollRequest>& requests) {
+  std::vector<RollResult> results(requests.size());
+  std::atomic<size_t> next_index = 0;
+
+  std::exception_ptr worker_exception;
+  std::mutex worker_exception_mutex;
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < getThreadCount(); i++) {
+    workers.emplace_back([&]() {
+      try {
+        rollOnWorker(options, requests, results, next_index);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(worker_exception_mutex);
+        worker_exception = std::current_exception();
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (worker_exception) {
+    std::rethrow_exception(worker_exception);
+  }
+
+  return results;
+}
+
+RollRequest BatchRoller::makeRandomRequest(unsigned int seed) {
+  std::mt19937 random_engine(seed);
+  std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+  glm::quat rotation =
+      glm::normalize(glm::quat(unit(random_engine), unit(random_engine),
+                               unit(random_engine), unit(random_engine)));
+
+  return {
+      .position = glm::vec3(0.f, 0.f, 0.f),
+      .rotation = rotation,
+      .linear_velocity =
+          glm::vec3(unit(random_engine), 0.f, unit(random_engine)) * 2.f,
+      .angular_velocity = glm::vec3(unit(random_engine), unit(random_engine),
+                                    unit(random_engine)) *
+                          10.f,
+      .seed = seed,
+  };
+}
+
+unsigned int BatchRoller::getThreadCount() const {
+  if (options.thread_count > 0) {
+    return options.thread_count;
+  }
+
+  return std::max(1u, std::thread::hardware_concurrency());
+}
@@ -0,0 +1,108 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./HeadlessRoot.h"
+
+#include <chrono>
+
+float RollStatistics::getRollsPerSecond() const {
+  return elapsed_ms > 0 ? roll_count * 1000.f / elapsed_ms : 0.f;
+}
+
+float RollStatistics::getStepsPerSecond() const {
+  return elapsed_ms > 0 ? step_count * 1000.f / elapsed_ms : 0.f;
+}
+
+HeadlessRoot::HeadlessRoot(const HeadlessRootOptions& options)
+    : time_step_ms(options.time_step_ms),
+      max_steps_per_roll(options.max_steps_per_roll) {
+  scene_manager = std::make_unique<SceneManager>(
+      options.camera, options.ambient_light, options.directional_light,
+      SceneManagerOptions{
+          .physics_thread_count = options.physics_thread_count,
+          .settle_detector_options = {},
+      });
+}
+
+int HeadlessRoot::simulateRoll() {
+  auto& settle_detector = scene_manager->settle_detector;
+
+  clearContacts();
+  settle_detector.reset();
+
+  int step_count = 0;
+  while (step_count < max_steps_per_roll) {
+    scene_manager->stepDynamicsWorld(time_step_ms);
+    step_count++;
+
+    if (settle_detector.isWatching() ? settle_detector.isSettled()
+                                     : isSceneResting()) {
+      break;
+    }
+  }
+
+  return step_count;
+}
+
+RollStatistics HeadlessRoot::simulateRolls(
+    int roll_count, const std::function<void(int)>& setup_func) {
+  RollStatistics statistics = {roll_count, 0, 0.f};
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  for (int roll_index = 0; roll_index < roll_count; roll_index++) {
+    setup_func(roll_index);
+    statistics.step_count += simulateRoll();
+  }
+
+  auto end_time = std::chrono::steady_clock::now();
+  statistics.elapsed_ms =
+      std::chrono::duration<float, std::milli>(end_time - start_time).count();
+
+  return statistics;
+}
+
+bool HeadlessRoot::isSceneResting() const {
+  for (auto& entity_ref : scene_manager->getEntities()) {
+    if (!entity_ref.get().physics_module->isResting()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void HeadlessRoot::clearContacts() {
+  auto& dynamics_world = *scene_manager->bt_dynamics_world;
+  auto* pair_cache = dynamics_world.getBroadphase()->getOverlappingPairCache();
+
+  // Contacts cached from the previous roll would leak into the next one
+  for (auto& entity_ref : scene_manager->getEntities()) {
+    auto& rigid_body = entity_ref.get().physics_module->getRigidBody().get();
+
+    pair_cache->cleanProxyFromPairs(rigid_body.getBroadphaseHandle(),
+                                    dynamics_world.getDispatcher());
+    rigid_body.clearForces();
+  }
+}
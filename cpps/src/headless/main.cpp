@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "./BatchRoller.h"
+#include "./HeadlessRoot.h"
+
+int main(int argc, char** argv) {
+  int roll_count = argc > 1 ? std::stoi(argv[1]) : 10000;
+  std::string die_shape = argc > 3 ? argv[3] : "box";
+
+  BatchRollerOptions options;
+  if (argc > 2) {
+    // std::stoul accepts a leading minus sign and wraps the result
+    std::string thread_count_arg = argv[2];
+    unsigned long thread_count = std::stoul(thread_count_arg);
+    if (thread_count_arg.find('-') != std::string::npos || thread_count < 1 ||
+        thread_count > std::numeric_limits<unsigned int>::max()) {
+      std::cerr << "Invalid thread count: " << thread_count_arg << std::endl;
+      return 1;
+    }
+    options.thread_count = static_cast<unsigned int>(thread_count);
+  }
+  if (die_shape == "hull") {
+    options.die_shape = DieShape::CONVEX_HULL;
+  } else if (die_shape == "gimpact") {
+    options.die_shape = DieShape::TRIANGLE_MESH;
+  } else if (die_shape != "box") {
+    std::cerr << "Unknown die shape: " << die_shape << std::endl;
+    return 1;
+  }
+
+  BatchRoller batch_roller(options);
+
+  std::vector<RollRequest> requests(roll_count);
+  for (int i = 0; i < roll_count; i++) {
+    requests[i] = BatchRoller::makeRandomRequest(i);
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+  std::vector<RollResult> results = batch_roller.roll(requests);
+  auto end_time = std::chrono::steady_clock::now();
+
+  RollStatistics statistics = {
+      roll_count, 0,
+      std::chrono::duration<float, std::milli>(end_time - start_time).count()};
+
+  std::array<int, 6> face_counts = {};
+  int unsettled_count = 0;
+  for (auto& result : results) {
+    statistics.step_count += result.step_count;
+    face_counts[result.face]++;
+    if (!result.settled) {
+      unsettled_count++;
+    }
+  }
+
+  std::cout << statistics.roll_count << " rolls, " << statistics.step_count
+            << " steps in " << statistics.elapsed_ms << " ms on "
+            << batch_roller.getThreadCount() << " threads with a "
+            << die_shape << " die" << std::endl;
+  std::cout << statistics.getRollsPerSecond() << " rolls/s, "
+            << statistics.getStepsPerSecond() << " steps/s" << std::endl;
+
+  for (int face = 0; face < 6; face++) {
+    std::cout << "face " << face << ": " << face_counts[face] << std::endl;
+  }
+  std::cout << "unsettled: " << unsettled_count << std::endl;
+
+  return 0;
+}
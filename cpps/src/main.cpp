@@ -55,10 +55,12 @@ int main() {
   Root root({width, height, *camera, *ambient_light, *directional_light});
   root.setClearColor(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
 
+  std::string holder_mesh_cache_path = "assets/models/holder.mesh";
   std::string holder_model_path = "assets/models/holder.obj";
 
-  std::unique_ptr<Geometry> holder_geometry = std::make_unique<Geometry>(
-      GeometryUtils::loadObjToGeometry(holder_model_path));
+  std::unique_ptr<Geometry> holder_geometry =
+      std::make_unique<Geometry>(GeometryUtils::loadGeometry(
+          holder_mesh_cache_path, holder_model_path));
   std::unique_ptr<CubeGeometry> cube_geometry =
       std::make_unique<CubeGeometry>(0.1f, 0.1f, 0.1f);
 
@@ -118,13 +120,10 @@ int main() {
       std::make_unique<btBoxShape>(btBoxShape(btVector3(4.0f, 4.0f, 0.01f)));
   plane_collision_shape->setMargin(0.04f);
 
-  std::unique_ptr<btMotionState> plane_motion_state =
-      std::make_unique<btDefaultMotionState>(btDefaultMotionState(
-          btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, -2, 0))));
   std::unique_ptr<PhysicsModule> plane_physics_module =
-      std::make_unique<PhysicsModule>(0.f, btVector3(0, 0, 0),
-                                      std::move(plane_collision_shape),
-                                      std::move(plane_motion_state));
+      std::make_unique<PhysicsModule>(
+          0.f, btVector3(0, 0, 0), std::move(plane_collision_shape),
+          btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, -2, 0)));
 
   std::unique_ptr<Entity> cube_entity =
       std::make_unique<Entity>(std::move(cube), std::move(cube_physics_module));
@@ -24,77 +24,110 @@
 
 #include "./GpuResourceManagerOpenGL.h"
 
+#include <cstddef>
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "./UniformBlock.h"
 #include "./shader_source.h"
 
-GpuResourceManagerOpenGL::~GpuResourceManagerOpenGL() { cleanup(); }
+GpuResourceManagerOpenGL::~GpuResourceManagerOpenGL() {
+  cleanup();
 
-VertexObject GpuResourceManagerOpenGL::createVertexObject(
-    const Geometry* geometry) {
-  GLuint vao_id, vbo_id, ebo_id;
-
-  glGenVertexArrays(1, &vao_id);
-  glGenBuffers(1, &vbo_id);
-  glGenBuffers(1, &ebo_id);
-
-  unsigned int vertex_count = geometry->getIndices().size();
-
-  VertexObject vertex_object = {vao_id, vbo_id, ebo_id, vertex_count};
-
-  return vertex_object;
+  for (auto& frame_fence : frame_fences) {
+    if (frame_fence != nullptr) {
+      glDeleteSync(frame_fence);
+    }
+  }
 }
 
-void GpuResourceManagerOpenGL::updateVertexObject(const Geometry* geometry) {
-  auto& vertex_object = vertex_objects[geometry];
+// Vertices are uploaded straight from Geometry storage, so the struct itself
+// must be the interleaved GPU layout
+static_assert(std::is_standard_layout_v<Vertex>);
+static_assert(sizeof(Vertex) == 8 * sizeof(float),
+              "Vertex must be tightly packed position, normal and uv");
+static_assert(offsetof(Vertex, position) == 0);
+static_assert(offsetof(Vertex, normal) == 3 * sizeof(float));
+static_assert(offsetof(Vertex, texture_coord) == 6 * sizeof(float));
+static_assert(sizeof(QuantizedVertex) == 16);
+
+// Copies the first copy_size bytes of the buffer into a new one of size
+static GLuint resizeBuffer(GLuint buffer_id, GLsizeiptr copy_size,
+                           GLsizeiptr size) {
+  GLuint new_buffer_id;
+  glGenBuffers(1, &new_buffer_id);
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer_id);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+
+  if (copy_size > 0) {
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_id);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        copy_size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &buffer_id);
+  }
 
-  auto& vertices = geometry->getVertices();
-  auto& indices = geometry->getIndices();
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
-  GLuint vao_id = vertex_object.vao_id;
-  GLuint vbo_id = vertex_object.vbo_id;
-  GLuint ebo_id = vertex_object.ebo_id;
-  unsigned int vertex_count = vertex_object.vertex_count;
+  return new_buffer_id;
+}
 
-  std::vector<float> raw_vertices = std::vector<float>(vertices.size() * 8);
-  for (int i = 0; i < vertices.size(); i++) {
-    raw_vertices[i * 8] = vertices[i].position.x;
-    raw_vertices[i * 8 + 1] = vertices[i].position.y;
-    raw_vertices[i * 8 + 2] = vertices[i].position.z;
-    raw_vertices[i * 8 + 3] = vertices[i].normal.x;
-    raw_vertices[i * 8 + 4] = vertices[i].normal.y;
-    raw_vertices[i * 8 + 5] = vertices[i].normal.z;
-    raw_vertices[i * 8 + 6] = vertices[i].texture_coord.x;
-    raw_vertices[i * 8 + 7] = vertices[i].texture_coord.y;
+void GpuResourceManagerOpenGL::reserveGeometryPool(
+    GeometryPoolBuffers& buffers, VertexFormat vertex_format,
+    size_t old_vertex_capacity, size_t vertex_capacity,
+    size_t old_index_capacity, size_t index_capacity) {
+  if (buffers.vao_id == 0) {
+    glGenVertexArrays(1, &buffers.vao_id);
   }
 
-  // Bind the Vertex Array Object first, then bind and set vertex buffer(s), and
-  // then configure vertex attributes(s).
-  glBindVertexArray(vao_id);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-  glBufferData(GL_ARRAY_BUFFER, raw_vertices.size() * 4, raw_vertices.data(),
-               GL_STATIC_DRAW);
+  size_t vertex_size = getVertexSize(vertex_format);
+  if (vertex_capacity != old_vertex_capacity) {
+    buffers.vbo_id =
+        resizeBuffer(buffers.vbo_id, old_vertex_capacity * vertex_size,
+                     vertex_capacity * vertex_size);
+  }
+  if (index_capacity != old_index_capacity) {
+    buffers.ebo_id = resizeBuffer(buffers.ebo_id,
+                                  old_index_capacity * INDEX_ARENA_UNIT_SIZE,
+                                  index_capacity * INDEX_ARENA_UNIT_SIZE);
+  }
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * 4, indices.data(),
-               GL_STATIC_DRAW);
+  // The VAO keeps its id; only its buffer bindings are replaced
+  glBindVertexArray(buffers.vao_id);
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffers.vbo_id);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ebo_id);
+
+  if (vertex_format == VertexFormat::QUANTIZED) {
+    // Normalized fetches hand the shader the same vec3/vec2 inputs as floats
+    glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex),
+                          (void*)offsetof(QuantizedVertex, position));
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE,
+                          sizeof(QuantizedVertex),
+                          (void*)offsetof(QuantizedVertex, normal));
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE,
+                          sizeof(QuantizedVertex),
+                          (void*)offsetof(QuantizedVertex, texture_coord));
+  } else {
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void*)offsetof(Vertex, position));
+
+    // Normal attribute
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void*)offsetof(Vertex, normal));
+
+    // Texture Coordinate attribute
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void*)offsetof(Vertex, texture_coord));
+  }
 
-  // Position attribute
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
   glEnableVertexAttribArray(0);
-
-  // Normal attribute
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
-                        (void*)(4 * 3));
   glEnableVertexAttribArray(1);
-
-  // Texture Coordinate attribute
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
-                        (void*)(4 * (3 + 3)));
   glEnableVertexAttribArray(2);
 
   // Unbind buffers safely
@@ -103,9 +136,42 @@ void GpuResourceManagerOpenGL::updateVertexObject(const Geometry* geometry) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+void GpuResourceManagerOpenGL::uploadVertices(
+    const GeometryPoolBuffers& buffers, VertexFormat vertex_format,
+    size_t vertex_offset, const void* vertices, size_t vertex_count) {
+  size_t vertex_size = getVertexSize(vertex_format);
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffers.vbo_id);
+  glBufferSubData(GL_ARRAY_BUFFER, vertex_offset * vertex_size,
+                  vertex_count * vertex_size, vertices);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuResourceManagerOpenGL::uploadIndices(const GeometryPoolBuffers& buffers,
+                                             size_t byte_offset,
+                                             const void* indices, size_t size) {
+  // Element buffers are written outside any VAO so none is rebound by mistake
+  glBindVertexArray(0);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ebo_id);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, byte_offset, size, indices);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+bool GpuResourceManagerOpenGL::isBaseVertexSupported() {
+#ifdef TARGET_EMSCRIPTEN
+  // WebGL2 has no glDrawElementsBaseVertex
+  return false;
+#else
+  return true;
+#endif
+}
+
 ShaderProgramId GpuResourceManagerOpenGL::createShaderProgram(
-    MaterialType type) {
-  ShaderSource shader_source = getShaderSource(type);
+    MaterialType type, bool is_instanced) {
+  ShaderSource shader_source = getShaderSource(type, is_instanced);
 
   return createShaderProgramWithSources(
       shader_source.vertex_shader_source.c_str(),
@@ -160,37 +226,112 @@ ShaderProgramId GpuResourceManagerOpenGL::createShaderProgramWithSources(
   glDeleteShader(vertex_shader_id);
   glDeleteShader(fragment_shader_id);
 
+  // Resolve block indices once, so draws only need to bind buffers
+  for (size_t i = 0; i < UNIFORM_BLOCK_TYPE_COUNT; i++) {
+    UniformBlockType block_type = static_cast<UniformBlockType>(i);
+    GLuint block_index = glGetUniformBlockIndex(
+        shader_program_id, getUniformBlockName(block_type).c_str());
+
+    if (block_index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(shader_program_id, block_index,
+                            getUniformBlockBindingPoint(block_type));
+    }
+  }
+
   return shader_program_id;
 }
 
-UniformBufferId GpuResourceManagerOpenGL::createUniformBuffer() {
+UniformBufferId GpuResourceManagerOpenGL::createUniformBuffer(size_t size) {
   GLuint uniform_buffer_id;
   glGenBuffers(1, &uniform_buffer_id);
 
+  // Allocate the storage once; updates only overwrite it
+  glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer_id);
+  glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
   return uniform_buffer_id;
 }
 
 void GpuResourceManagerOpenGL::updateUniformBuffer(
     UniformBufferId uniform_buffer_id, const void* data_ptr, size_t size) {
   glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer_id);
-  glBufferData(GL_UNIFORM_BUFFER, size, data_ptr, GL_STATIC_DRAW);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data_ptr);
 
   glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-void GpuResourceManagerOpenGL::deleteShaderProgram(MaterialType type) {
-  ShaderProgramId shader_program_id = shader_program_ids[type];
+void GpuResourceManagerOpenGL::deleteShaderProgram(
+    ShaderProgramId shader_program_id) {
   glDeleteProgram(shader_program_id);
 }
 
-void GpuResourceManagerOpenGL::deleteVertexObject(const Geometry* geometry) {
-  VertexObject vertex_object = vertex_objects[geometry];
-  glDeleteVertexArrays(1, &vertex_object.vao_id);
-  glDeleteBuffers(1, &vertex_object.vbo_id);
-  glDeleteBuffers(1, &vertex_object.ebo_id);
+void GpuResourceManagerOpenGL::deleteGeometryPool(
+    const GeometryPoolBuffers& buffers) {
+  glDeleteVertexArrays(1, &buffers.vao_id);
+  glDeleteBuffers(1, &buffers.vbo_id);
+  glDeleteBuffers(1, &buffers.ebo_id);
 }
 
 void GpuResourceManagerOpenGL::deleteUniformBuffer(
     UniformBufferId uniform_buffer_id) {
   glDeleteBuffers(1, &uniform_buffer_id);
 }
+
+InstanceBufferId GpuResourceManagerOpenGL::createInstanceBuffer(size_t size) {
+  GLuint instance_buffer_id;
+  glGenBuffers(1, &instance_buffer_id);
+
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id);
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  return instance_buffer_id;
+}
+
+void GpuResourceManagerOpenGL::updateInstanceBuffer(
+    InstanceBufferId instance_buffer_id, const void* data_ptr, size_t size) {
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, size, data_ptr);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuResourceManagerOpenGL::deleteInstanceBuffer(
+    InstanceBufferId instance_buffer_id) {
+  glDeleteBuffers(1, &instance_buffer_id);
+}
+
+size_t GpuResourceManagerOpenGL::getUniformBufferOffsetAlignment() {
+  GLint alignment;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+  return static_cast<size_t>(alignment);
+}
+
+void GpuResourceManagerOpenGL::waitForFrame(int frame_index) {
+  GLsync& frame_fence = frame_fences[frame_index];
+  if (frame_fence == nullptr) {
+    return;
+  }
+
+  // Block until the GPU finished the frame that last used these buffers
+  GLenum wait_result = GL_TIMEOUT_EXPIRED;
+  while (wait_result == GL_TIMEOUT_EXPIRED) {
+    wait_result = glClientWaitSync(frame_fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                   1000000000);
+  }
+
+  glDeleteSync(frame_fence);
+  frame_fence = nullptr;
+}
+
+void GpuResourceManagerOpenGL::fenceFrame(int frame_index) {
+  if (FRAMES_IN_FLIGHT == 1) {
+    return;
+  }
+
+  frame_fences[frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Seongho Park
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "./render_state.h"
+
+#include "./shader_source.h"
+
+GLenum getIndexGlType(IndexType index_type) {
+  return index_type == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+bool isSameUniformRange(const UniformBufferRange& lhs,
+                        const UniformBufferRange& rhs) {
+  return lhs.uniform_buffer_id == rhs.uniform_buffer_id &&
+         lhs.offset == rhs.offset && lhs.size == rhs.size;
+}
+
+void bindUniformBufferRanges(
+    const UniformBufferBindings& bindings,
+    std::array<UniformBufferRange, UNIFORM_BLOCK_TYPE_COUNT>& bound_ranges,
+    RenderStatistics& statistics) {
+  for (size_t i = 0; i < UNIFORM_BLOCK_TYPE_COUNT; i++) {
+    if ((bindings.mask & (1u << i)) == 0) {
+      continue;
+    }
+
+    auto& buffer_range = bindings.ranges[i];
+    auto& bound_range = bound_ranges[i];
+    if (isSameUniformRange(buffer_range, bound_range)) {
+      continue;
+    }
+
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER,
+        getUniformBlockBindingPoint(static_cast<UniformBlockType>(i)),
+        buffer_range.uniform_buffer_id, buffer_range.offset, buffer_range.size);
+    bound_range = buffer_range;
+    statistics.uniform_buffer_change_count++;
+  }
+}
+
+// The matrix columns are plain vertex attributes advanced per instance
+void bindInstanceData(InstanceBufferId instance_buffer_id,
+                      size_t instance_offset) {
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id);
+  for (unsigned int i = 0; i < 4; i++) {
+    GLuint location = INSTANCE_MODEL_MATRIX_LOCATION + i;
+    glVertexAttribPointer(
+        location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+        reinterpret_cast<void*>(instance_offset +
+                                offsetof(InstanceData, model_matrix) +
+                                sizeof(glm::vec4) * i));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+  glVertexAttribPointer(
+      INSTANCE_POSITION_DECODE_LOCATION, 4, GL_FLOAT, GL_FALSE,
+      sizeof(InstanceData),
+      reinterpret_cast<void*>(instance_offset +
+                              offsetof(InstanceData, position_decode)));
+  glEnableVertexAttribArray(INSTANCE_POSITION_DECODE_LOCATION);
+  glVertexAttribDivisor(INSTANCE_POSITION_DECODE_LOCATION, 1);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -26,6 +26,24 @@
 
 #include "./opengl.h"
 
+std::string model_block_source = R"(
+    layout (std140) uniform ModelBlock
+    {
+        mat4 u_model_matrix;
+        vec4 u_position_decode;
+    };
+)";
+
+// Instanced draws stream the model matrix and position decode per instance,
+// so the vertex body below stays shared by both variants
+std::string instanced_model_source = R"(
+    layout (location = 3) in mat4 a_modelMatrix;
+    layout (location = 7) in vec4 a_positionDecode;
+
+    #define u_model_matrix a_modelMatrix
+    #define u_position_decode a_positionDecode
+)";
+
 std::string basic_vertex_source = R"(
     layout (std140) uniform CameraBlock
     {
@@ -34,11 +52,6 @@ std::string basic_vertex_source = R"(
         vec3 u_camera_eye;
     };
 
-    layout (std140) uniform ModelBlock
-    {
-        mat4 u_model_matrix;
-    };
-
     layout (location = 0) in vec3 a_position;
     layout (location = 1) in vec3 a_normal;
     layout (location = 2) in vec2 a_texCoord;
@@ -49,9 +62,12 @@ std::string basic_vertex_source = R"(
 
     void main()
     {
-        gl_Position = u_camera_projectionMatrix * u_camera_viewMatrix * u_model_matrix * vec4(a_position, 1.0);
+        // Identity for float vertices; rescales quantized ones
+        vec3 position = a_position * u_position_decode.w + u_position_decode.xyz;
 
-        vec4 modelPosition = u_model_matrix * vec4(a_position, 1.0);
+        gl_Position = u_camera_projectionMatrix * u_camera_viewMatrix * u_model_matrix * vec4(position, 1.0);
+
+        vec4 modelPosition = u_model_matrix * vec4(position, 1.0);
         v_position = modelPosition.xyz;
 
         mat3 normalMatrix = transpose(inverse(mat3(u_model_matrix)));
@@ -160,7 +176,7 @@ std::string phong_fragment_source = R"(
     }
 )";
 
-ShaderSource getShaderSource(MaterialType type) {
+ShaderSource getShaderSource(MaterialType type, bool is_instanced) {
   std::string shader_prefix = SHADER_PREFIX;
 
   std::string base_vertex_source;
@@ -191,7 +207,11 @@ ShaderSource getShaderSource(MaterialType type) {
       throw std::runtime_error("Invalid MaterialType");
   }
 
-  std::string vertex_shader_source = shader_prefix + base_vertex_source;
+  std::string model_source =
+      is_instanced ? instanced_model_source : model_block_source;
+
+  std::string vertex_shader_source =
+      shader_prefix + model_source + base_vertex_source;
   std::string fragment_shader_source = shader_prefix + base_fragment_source;
 
   return {std::move(vertex_shader_source), std::move(fragment_shader_source)};